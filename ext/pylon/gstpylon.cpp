@@ -38,11 +38,21 @@
 #include "gst/pylon/gstpylonmetaprivate.h"
 #include "gst/pylon/gstpylonobject.h"
 #include "gstchildinspector.h"
+#include "gstpylonbufferpool.h"
 #include "gstpylon.h"
+#include "gstpylondebayer.h"
+#include "gstpylonformatconverter.h"
 #include "gstpylondisconnecthandler.h"
 #include "gstpylonimagehandler.h"
+#include "gstpylonunpack.h"
 
+#include <algorithm>
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
 
 #ifdef _MSC_VER  // MSVC
 #pragma warning(push)
@@ -71,6 +81,16 @@ typedef struct {
 typedef struct {
   const std::string st_name;
   std::vector<PixelFormatMappingType> format_map;
+  /* Packed camera formats are unpacked on the host for this structure */
+  bool unpack;
+  /* Unpacked values are scaled to the full 16 bit range for this
+   * structure */
+  bool msb;
+  /* 8 bit Bayer formats may be debayered on the host for this structure */
+  bool debayer;
+  /* Formats without GStreamer equivalent may be converted by pylon for this
+   * structure */
+  bool convert;
 } GstStPixelFormats;
 
 /* prototypes */
@@ -81,6 +101,9 @@ static Pylon::String_t gst_pylon_get_camera_fullname(
     Pylon::CBaslerUniversalInstantCamera &camera);
 static Pylon::String_t gst_pylon_get_sgrabber_name(
     Pylon::CBaslerUniversalInstantCamera &camera);
+static std::string gst_pylon_get_cache_name(
+    Pylon::CBaslerUniversalInstantCamera &camera,
+    const Pylon::String_t &device_type);
 static void free_ptr_grab_result(gpointer data);
 static void gst_pylon_query_format(
     GstPylon *self, GValue *outvalue,
@@ -95,7 +118,8 @@ static void gst_pylon_query_caps(
     const std::vector<PixelFormatMappingType> &pixel_format_mapping);
 static void gst_pylon_add_result_meta(
     GstPylon *self, GstBuffer *buf,
-    Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr);
+    Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr,
+    GstPylonChunkDecodingEnum chunk_decoding);
 static std::vector<std::string> gst_pylon_gst_to_pfnc(
     const std::string &gst_format,
     const std::vector<PixelFormatMappingType> &pixel_format_mapping);
@@ -105,6 +129,9 @@ static std::vector<std::string> gst_pylon_pfnc_to_gst(
 static std::vector<std::string> gst_pylon_pfnc_list_to_gst(
     const GenApi::StringList_t &genapi_formats,
     const std::vector<PixelFormatMappingType> &pixel_format_mapping);
+static std::vector<PixelFormatMappingType> gst_pylon_get_format_map(
+    const GstStPixelFormats &gst_structure_format, GstPylonDebayerEnum debayer,
+    gboolean convert);
 static void gst_pylon_append_properties(
     Pylon::CBaslerUniversalInstantCamera *camera,
     const Pylon::String_t &device_full_name,
@@ -116,12 +143,11 @@ static void gst_pylon_append_camera_properties(
 static void gst_pylon_append_stream_grabber_properties(
     Pylon::CBaslerUniversalInstantCamera *camera, gchar **sgrabber_properties,
     guint alignment);
-typedef void (*GetStringProperties)(Pylon::CBaslerUniversalInstantCamera *,
-                                    gchar **, guint);
-static gchar *gst_pylon_get_string_properties(
-    GetStringProperties get_device_string_properties);
 
 static constexpr gint DEFAULT_ALIGNMENT = 35;
+static constexpr guint MAX_INTROSPECTION_WORKERS = 16;
+static constexpr const gchar *CAMERA_DEVICE_TYPE = "Camera";
+static constexpr const gchar *SGRABBER_DEVICE_TYPE = "Stream Grabber";
 
 struct _GstPylon {
   GstElement *gstpylonsrc;
@@ -131,28 +157,98 @@ struct _GstPylon {
   GObject *gstream_grabber;
   GstPylonImageHandler image_handler;
   GstPylonDisconnectHandler disconnect_handler;
+  GstBufferPool *buffer_pool = NULL;
+  GstBufferPool *output_pool = NULL;
+  GstPylonChunkCache *chunk_cache = NULL;
+  GstPylonUnpackFormat unpack_format = GST_PYLON_UNPACK_NONE;
+  gboolean unpack_msb = FALSE;
+  GstPylonDebayer debayer;
+  bool debayering = false;
+  GstPylonFormatConverter converter;
+  bool converting = false;
 
   std::string requested_device_user_name;
   std::string requested_device_serial_number;
   gint requested_device_index;
+
+  GstPylonGrabStrategyEnum grab_strategy = ENUM_LATEST_IMAGE_ONLY;
+  guint queue_depth = 1;
+  guint output_queue_size = 1;
+  guint max_num_buffer = 1;
 };
 
 static const std::vector<PixelFormatMappingType> pixel_format_mapping_raw = {
-    {"Mono8", "GRAY8"},        {"RGB8Packed", "RGB"},
-    {"BGR8Packed", "BGR"},     {"RGB8", "RGB"},
-    {"BGR8", "BGR"},           {"YCbCr422_8", "YUY2"},
-    {"YUV422_8_UYVY", "UYVY"}, {"YUV422_8", "YUY2"},
-    {"YUV422Packed", "UYVY"},  {"YUV422_YUYV_Packed", "YUY2"}};
+    {"Mono8", "GRAY8"},            {"RGB8Packed", "RGB"},
+    {"BGR8Packed", "BGR"},         {"RGB8", "RGB"},
+    {"BGR8", "BGR"},               {"YCbCr422_8", "YUY2"},
+    {"YUV422_8_UYVY", "UYVY"},     {"YUV422_8", "YUY2"},
+    {"YUV422Packed", "UYVY"},      {"YUV422_YUYV_Packed", "YUY2"},
+    {"Mono12p", "GRAY16_LE"},      {"Mono12Packed", "GRAY16_LE"},
+    {"Mono10p", "GRAY16_LE"},      {"Mono16", "GRAY16_LE"},
+    {"Mono12", "GRAY16_LE"},       {"Mono10", "GRAY16_LE"}};
 
 static const std::vector<PixelFormatMappingType> pixel_format_mapping_bayer = {
     {"BayerBG8", "bggr"},
+    {"BayerBG16", "bggr16le"},
+    {"BayerBG12p", "bggr12le"},
+    {"BayerBG12Packed", "bggr12le"},
+    {"BayerBG12", "bggr12le"},
+    {"BayerBG10p", "bggr10le"},
+    {"BayerBG10", "bggr10le"},
     {"BayerGR8", "grbg"},
+    {"BayerGR16", "grbg16le"},
+    {"BayerGR12p", "grbg12le"},
+    {"BayerGR12Packed", "grbg12le"},
+    {"BayerGR12", "grbg12le"},
+    {"BayerGR10p", "grbg10le"},
+    {"BayerGR10", "grbg10le"},
     {"BayerRG8", "rggb"},
-    {"BayerGB8", "gbrg"}};
+    {"BayerRG16", "rggb16le"},
+    {"BayerRG12p", "rggb12le"},
+    {"BayerRG12Packed", "rggb12le"},
+    {"BayerRG12", "rggb12le"},
+    {"BayerRG10p", "rggb10le"},
+    {"BayerRG10", "rggb10le"},
+    {"BayerGB8", "gbrg"},
+    {"BayerGB16", "gbrg16le"},
+    {"BayerGB12p", "gbrg12le"},
+    {"BayerGB12Packed", "gbrg12le"},
+    {"BayerGB12", "gbrg12le"},
+    {"BayerGB10p", "gbrg10le"},
+    {"BayerGB10", "gbrg10le"}};
+
+/* Packed frames forwarded untouched, e.g. to record them as they come out
+ * of the camera */
+static const std::vector<PixelFormatMappingType> pixel_format_mapping_packed =
+    {{"Mono10p", "Mono10p"},
+     {"Mono12p", "Mono12p"},
+     {"Mono12Packed", "Mono12Packed"}};
+
+/* 8 bit Bayer formats converted on the host if debayering is enabled */
+static const std::vector<PixelFormatMappingType> pixel_format_mapping_debayer =
+    {{"BayerRG8", "RGB"},   {"BayerRG8", "BGRx"}, {"BayerRG8", "GRAY8"},
+     {"BayerBG8", "RGB"},   {"BayerBG8", "BGRx"}, {"BayerBG8", "GRAY8"},
+     {"BayerGR8", "RGB"},   {"BayerGR8", "BGRx"}, {"BayerGR8", "GRAY8"},
+     {"BayerGB8", "RGB"},   {"BayerGB8", "BGRx"}, {"BayerGB8", "GRAY8"}};
+
+/* Formats without GStreamer equivalent converted on the host by pylon to
+ * each of the formats below if conversion is enabled. Only the ones the
+ * installed pylon is able to convert are offered. */
+static const std::vector<std::string> pixel_formats_convert = {
+    "YCbCr411_8",     "BiColorRGBG8",   "BiColorBGRG8",   "BiColorRGBG10",
+    "BiColorRGBG10p", "BiColorBGRG10",  "BiColorBGRG10p", "BiColorRGBG12",
+    "BiColorRGBG12p", "BiColorBGRG12",  "BiColorBGRG12p", "RGB10",
+    "RGB10p32",       "RGB10Packed",    "RGB12",          "RGB12Packed",
+    "RGB12V1Packed",  "BGR10",          "BGR12"};
+
+static const std::vector<std::string> pixel_formats_convert_output = {
+    "RGB", "BGRx", "GRAY8"};
 
 static const std::vector<GstStPixelFormats> gst_structure_formats = {
-    {"video/x-raw", pixel_format_mapping_raw},
-    {"video/x-bayer", pixel_format_mapping_bayer}};
+    {"video/x-raw", pixel_format_mapping_raw, true, true, true, true},
+    {"video/x-bayer", pixel_format_mapping_bayer, true, false, false, false},
+    {"video/x-pylon-packed", pixel_format_mapping_packed, false, false, false,
+     false}};
 
 void gst_pylon_initialize() { Pylon::PylonInitialize(); }
 
@@ -166,6 +262,18 @@ static Pylon::String_t gst_pylon_get_sgrabber_name(
   return gst_pylon_get_camera_fullname(camera) + " StreamGrabber";
 }
 
+static std::string gst_pylon_get_cache_name(
+    Pylon::CBaslerUniversalInstantCamera &camera,
+    const Pylon::String_t &device_type) {
+  /* The introspected features are the same for every device of a model
+   * running the same firmware, so the serial number is left out */
+  const Pylon::CDeviceInfo &info = camera.GetDeviceInfo();
+
+  return std::string(info.GetModelName()) + "_" +
+         std::string(info.GetDeviceVersion()) + "_" +
+         Pylon::GetPylonVersionString() + "_" + std::string(device_type);
+}
+
 static std::string gst_pylon_query_default_set(
     const Pylon::CBaslerUniversalInstantCamera &camera) {
   std::string set;
@@ -281,6 +389,16 @@ GstPylon *gst_pylon_new(GstElement *gstpylonsrc, const gchar *device_user_name,
 
     self->camera->Attach(factory.CreateDevice(device_info));
 
+    /* Let pylon grab directly into memory owned by the buffer pool */
+    self->buffer_pool = gst_pylon_buffer_pool_new();
+    self->camera->SetBufferFactory(
+        gst_pylon_buffer_pool_get_buffer_factory(
+            GST_PYLON_BUFFER_POOL(self->buffer_pool)),
+        Pylon::Cleanup_None);
+    /* Packed formats are grabbed into the pylon pool and unpacked into
+     * buffers from this one */
+    self->output_pool = gst_buffer_pool_new();
+
     self->camera->RegisterImageEventHandler(&self->image_handler,
                                             Pylon::RegistrationMode_Append,
                                             Pylon::Cleanup_None);
@@ -297,19 +415,40 @@ GstPylon *gst_pylon_new(GstElement *gstpylonsrc, const gchar *device_user_name,
     }
 
     GenApi::INodeMap &cam_nodemap = self->camera->GetNodeMap();
-    self->gcamera = gst_pylon_object_new(
-        self->camera, gst_pylon_get_camera_fullname(*self->camera),
-        &cam_nodemap);
+    self->chunk_cache = gst_pylon_chunk_cache_new(cam_nodemap);
+
+    /* The device types are only registered up front when inspecting the
+     * element, register them now otherwise */
+    Pylon::String_t camera_name = gst_pylon_get_camera_fullname(*self->camera);
+    gst_pylon_object_register(
+        camera_name,
+        gst_pylon_get_cache_name(*self->camera, CAMERA_DEVICE_TYPE),
+        cam_nodemap);
+    self->gcamera =
+        gst_pylon_object_new(self->camera, camera_name, &cam_nodemap);
 
     GenApi::INodeMap &sgrabber_nodemap =
         self->camera->GetStreamGrabberNodeMap();
-    self->gstream_grabber = gst_pylon_object_new(
-        self->camera, gst_pylon_get_sgrabber_name(*self->camera),
-        &sgrabber_nodemap);
+    Pylon::String_t sgrabber_name = gst_pylon_get_sgrabber_name(*self->camera);
+    gst_pylon_object_register(
+        sgrabber_name,
+        gst_pylon_get_cache_name(*self->camera, SGRABBER_DEVICE_TYPE),
+        sgrabber_nodemap);
+    self->gstream_grabber =
+        gst_pylon_object_new(self->camera, sgrabber_name, &sgrabber_nodemap);
 
   } catch (const Pylon::GenericException &e) {
     g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED, "%s",
                 e.GetDescription());
+    if (self->chunk_cache) {
+      gst_pylon_chunk_cache_free(self->chunk_cache);
+    }
+    if (self->buffer_pool) {
+      gst_object_unref(self->buffer_pool);
+    }
+    if (self->output_pool) {
+      gst_object_unref(self->output_pool);
+    }
     delete self;
     self = NULL;
   }
@@ -384,21 +523,81 @@ void gst_pylon_free(GstPylon *self) {
 
   self->camera->DeregisterImageEventHandler(&self->image_handler);
   self->camera->DeregisterConfiguration(&self->disconnect_handler);
+  gst_pylon_chunk_cache_free(self->chunk_cache);
   self->camera->Close();
   g_object_unref(self->gcamera);
+  /* Buffers still in the pipeline keep the pool alive until they are
+   * returned */
+  gst_object_unref(self->buffer_pool);
+  gst_object_unref(self->output_pool);
 
   delete self;
 }
 
-gboolean gst_pylon_start(GstPylon *self, GError **err) {
+static Pylon::EGrabStrategy gst_pylon_get_grab_strategy(
+    GstPylonGrabStrategyEnum grab_strategy) {
+  switch (grab_strategy) {
+    case ENUM_ONE_BY_ONE:
+      return Pylon::GrabStrategy_OneByOne;
+    case ENUM_LATEST_IMAGES:
+      return Pylon::GrabStrategy_LatestImages;
+    case ENUM_LATEST_IMAGE_ONLY:
+    default:
+      return Pylon::GrabStrategy_LatestImageOnly;
+  }
+}
+
+gboolean gst_pylon_start(GstPylon *self, guint queue_depth,
+                         GstPylonGrabStrategyEnum grab_strategy,
+                         guint output_queue_size, guint max_num_buffer,
+                         GError **err) {
   gboolean ret = TRUE;
 
   g_return_val_if_fail(self, FALSE);
   g_return_val_if_fail(err && *err == NULL, FALSE);
 
   try {
-    self->camera->StartGrabbing(Pylon::GrabStrategy_LatestImageOnly,
+    /* Zero keeps the number of buffers allocated by pylon */
+    if (max_num_buffer > 0) {
+      self->camera->MaxNumBuffer.SetValue(max_num_buffer);
+    }
+
+    /* Respect the buffer count negotiated for the pool */
+    GstStructure *config = gst_buffer_pool_get_config(self->buffer_pool);
+    guint min_buffers = 0;
+    guint max_buffers = 0;
+    gst_buffer_pool_config_get_params(config, NULL, NULL, &min_buffers,
+                                      &max_buffers);
+    gst_structure_free(config);
+
+    guint num_buffers = self->camera->MaxNumBuffer.GetValue();
+    if (max_buffers > 0 && num_buffers > max_buffers) {
+      num_buffers = max_buffers;
+    }
+    if (num_buffers < min_buffers) {
+      num_buffers = min_buffers;
+    }
+    self->camera->MaxNumBuffer.SetValue(num_buffers);
+
+    /* The output queue size is only honored by the LatestImages strategy */
+    if (ENUM_LATEST_IMAGES == grab_strategy) {
+      self->camera->OutputQueueSize.SetValue(output_queue_size);
+    }
+
+    /* OneByOne promises not to drop images on the host, so the grab loop
+     * waits for room in the queue. Once all pylon buffers are filled, new
+     * frames are dropped by the transport layer instead. */
+    self->image_handler.SetQueueDepth(queue_depth,
+                                      ENUM_ONE_BY_ONE == grab_strategy);
+    /* Chunk nodemaps are reallocated along with the grab buffers */
+    gst_pylon_chunk_cache_invalidate(self->chunk_cache);
+    self->camera->StartGrabbing(gst_pylon_get_grab_strategy(grab_strategy),
                                 Pylon::GrabLoop_ProvidedByInstantCamera);
+
+    self->grab_strategy = grab_strategy;
+    self->queue_depth = queue_depth;
+    self->output_queue_size = output_queue_size;
+    self->max_num_buffer = self->camera->MaxNumBuffer.GetValue();
   } catch (const Pylon::GenericException &e) {
     g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED, "%s",
                 e.GetDescription());
@@ -415,7 +614,12 @@ gboolean gst_pylon_stop(GstPylon *self, GError **err) {
   g_return_val_if_fail(err && *err == NULL, FALSE);
 
   try {
+    /* Let a grab loop waiting for room in the queue finish */
+    self->image_handler.InterruptWaitForSpace();
     self->camera->StopGrabbing();
+    /* Release the pylon buffers held by images nobody is going to collect */
+    self->image_handler.FlushImages();
+    self->converter.Flush();
   } catch (const Pylon::GenericException &e) {
     g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED, "%s",
                 e.GetDescription());
@@ -430,13 +634,284 @@ void gst_pylon_interrupt_capture(GstPylon *self) {
   self->image_handler.InterruptWaitForImage();
 }
 
+guint64 gst_pylon_get_dropped_images(GstPylon *self) {
+  g_return_val_if_fail(self, 0);
+
+  return self->image_handler.GetDroppedImages();
+}
+
+GstBufferPool *gst_pylon_get_buffer_pool(GstPylon *self) {
+  g_return_val_if_fail(self, NULL);
+
+  /* Converted frames don't fit the grab buffers, hand out plain buffers */
+  if (GST_PYLON_UNPACK_NONE != self->unpack_format || self->debayering ||
+      self->converting) {
+    return self->output_pool;
+  }
+
+  return self->buffer_pool;
+}
+
+gboolean gst_pylon_latch_timestamp(GstPylon *self, guint64 *timestamp,
+                                   GError **err) {
+  gboolean ret = TRUE;
+
+  g_return_val_if_fail(self, FALSE);
+  g_return_val_if_fail(timestamp, FALSE);
+  g_return_val_if_fail(err && *err == NULL, FALSE);
+
+  try {
+    if (self->camera->TimestampLatch.IsWritable()) {
+      self->camera->TimestampLatch.Execute();
+      *timestamp = self->camera->TimestampLatchValue.GetValue();
+    } else if (self->camera->GevTimestampControlLatch.IsWritable()) {
+      self->camera->GevTimestampControlLatch.Execute();
+      *timestamp = self->camera->GevTimestampValue.GetValue();
+    } else {
+      throw Pylon::GenericException(
+          "The camera does not support latching its timestamp", __FILE__,
+          __LINE__);
+    }
+  } catch (const Pylon::GenericException &e) {
+    g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED, "%s",
+                e.GetDescription());
+    ret = FALSE;
+  }
+
+  return ret;
+}
+
+guint64 gst_pylon_get_timestamp_frequency(GstPylon *self) {
+  /* Cameras without a tick frequency count nanoseconds */
+  guint64 frequency = GST_SECOND;
+
+  g_return_val_if_fail(self, frequency);
+
+  try {
+    if (self->camera->GevTimestampTickFrequency.IsReadable()) {
+      frequency = self->camera->GevTimestampTickFrequency.GetValue();
+    }
+  } catch (const Pylon::GenericException &e) {
+    GST_WARNING("Unable to read the timestamp tick frequency: %s",
+                e.GetDescription());
+  }
+
+  return frequency > 0 ? frequency : GST_SECOND;
+}
+
+guint gst_pylon_get_max_queued_images(GstPylon *self) {
+  guint max_queued = 0;
+
+  g_return_val_if_fail(self, 0);
+
+  /* Images waiting in the pylon output queue plus the ones waiting in the
+   * handler queue */
+  switch (self->grab_strategy) {
+    case ENUM_ONE_BY_ONE:
+      max_queued = self->max_num_buffer;
+      break;
+    case ENUM_LATEST_IMAGES:
+      max_queued = self->output_queue_size;
+      break;
+    case ENUM_LATEST_IMAGE_ONLY:
+    default:
+      max_queued = 1;
+      break;
+  }
+
+  /* Images handed to the conversion workers ahead of time free room in the
+   * handler queue */
+  if (self->converting) {
+    max_queued += self->converter.GetMaxPending() - 1;
+  }
+
+  return max_queued + self->queue_depth;
+}
+
 static void gst_pylon_add_result_meta(
     GstPylon *self, GstBuffer *buf,
-    Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr) {
+    Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr,
+    GstPylonChunkDecodingEnum chunk_decoding) {
+  GstPylonChunkDecoding decoding = GST_PYLON_CHUNK_DECODING_EAGER;
+
   g_return_if_fail(self);
   g_return_if_fail(buf);
 
-  gst_buffer_add_pylon_meta(buf, grab_result_ptr);
+  switch (chunk_decoding) {
+    case ENUM_CHUNKS_LAZY:
+      decoding = GST_PYLON_CHUNK_DECODING_LAZY;
+      break;
+    case ENUM_CHUNKS_OFF:
+      decoding = GST_PYLON_CHUNK_DECODING_OFF;
+      break;
+    case ENUM_CHUNKS_EAGER:
+    default:
+      decoding = GST_PYLON_CHUNK_DECODING_EAGER;
+      break;
+  }
+
+  gst_buffer_add_pylon_meta(buf, grab_result_ptr, self->chunk_cache,
+                            decoding);
+}
+
+static gsize gst_pylon_get_output_stride(GstPylon *self, guint width) {
+  guint pixel_stride = sizeof(guint16);
+
+  if (self->debayering) {
+    pixel_stride = self->debayer.GetPixelStride();
+  } else if (self->converting) {
+    pixel_stride = self->converter.GetPixelStride();
+  }
+
+  return GST_ROUND_UP_4(width * pixel_stride);
+}
+
+static GstBuffer *gst_pylon_acquire_output_buffer(GstPylon *self, bool wait) {
+  GstBuffer *buf = NULL;
+  GstBufferPoolAcquireParams params = {};
+
+  if (!wait) {
+    params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+  }
+
+  if (GST_FLOW_OK !=
+      gst_buffer_pool_acquire_buffer(self->output_pool, &buf, &params)) {
+    return NULL;
+  }
+
+  return buf;
+}
+
+/* Fall back to a fresh buffer while the pool is not active yet */
+static GstBuffer *gst_pylon_fit_output_buffer(GstBuffer *buf, gsize size) {
+  if (buf && gst_buffer_get_size(buf) < size) {
+    gst_buffer_unref(buf);
+    buf = NULL;
+  }
+
+  if (!buf) {
+    buf = gst_buffer_new_allocate(NULL, size, NULL);
+  }
+
+  return buf;
+}
+
+static gboolean gst_pylon_finish_conversion(
+    Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr, GstBuffer **buf,
+    gboolean converted) {
+  /* Failed grabs kept on purpose may be truncated, deliver them blank */
+  if (!converted && !grab_result_ptr->GrabSucceeded()) {
+    gst_buffer_memset(*buf, 0, 0, gst_buffer_get_size(*buf));
+    converted = TRUE;
+  }
+
+  if (!converted) {
+    gst_buffer_unref(*buf);
+    *buf = NULL;
+  }
+
+  return converted;
+}
+
+static gboolean gst_pylon_convert_grab_result(
+    GstPylon *self, Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr,
+    GstBuffer **buf) {
+  g_return_val_if_fail(self, FALSE);
+  g_return_val_if_fail(buf, FALSE);
+
+  guint width = grab_result_ptr->GetWidth();
+  guint height = grab_result_ptr->GetHeight();
+  gsize dst_stride = gst_pylon_get_output_stride(self, width);
+
+  *buf = gst_pylon_fit_output_buffer(
+      gst_pylon_acquire_output_buffer(self, true), dst_stride * height);
+
+  /* Zero means pylon doesn't know the stride, rows are then contiguous */
+  size_t src_stride = 0;
+  if (!grab_result_ptr->GetStride(src_stride)) {
+    src_stride = 0;
+  }
+
+  GstMapInfo info;
+  if (!gst_buffer_map(*buf, &info, GST_MAP_WRITE)) {
+    gst_buffer_unref(*buf);
+    *buf = NULL;
+    return FALSE;
+  }
+
+  const guint8 *src = static_cast<const guint8 *>(grab_result_ptr->GetBuffer());
+  gsize src_size = grab_result_ptr->GetBufferSize();
+  gboolean ret = FALSE;
+
+  if (self->debayering) {
+    ret = self->debayer.Process(src, src_size, src_stride, info.data,
+                                dst_stride, width, height);
+  } else {
+    ret = gst_pylon_unpack(self->unpack_format, self->unpack_msb, src,
+                           src_size, src_stride, info.data, dst_stride, width,
+                           height);
+  }
+
+  gst_buffer_unmap(*buf, &info);
+
+  return gst_pylon_finish_conversion(grab_result_ptr, buf, ret);
+}
+
+static void gst_pylon_submit_conversion(
+    GstPylon *self, Pylon::CBaslerUniversalGrabResultPtr *grab_result_ptr,
+    GstBuffer *buf) {
+  gsize stride =
+      gst_pylon_get_output_stride(self, (*grab_result_ptr)->GetWidth());
+  gsize size = stride * (*grab_result_ptr)->GetHeight();
+
+  self->converter.Submit(grab_result_ptr,
+                         gst_pylon_fit_output_buffer(buf, size), stride);
+}
+
+static Pylon::CBaslerUniversalGrabResultPtr *gst_pylon_wait_for_image(
+    GstPylon *self, GstBuffer **converted_buf, gboolean *converted) {
+  *converted_buf = NULL;
+  *converted = FALSE;
+
+  if (!self->converting) {
+    return self->image_handler.WaitForImage();
+  }
+
+  if (0 == self->converter.GetPending()) {
+    Pylon::CBaslerUniversalGrabResultPtr *grab_result_ptr =
+        self->image_handler.WaitForImage();
+    if (!grab_result_ptr) {
+      return NULL;
+    }
+    gst_pylon_submit_conversion(self, grab_result_ptr,
+                                gst_pylon_acquire_output_buffer(self, true));
+  }
+
+  /* Hand the images already grabbed to the idle workers, so they are
+   * converted while the oldest one goes downstream. Don't wait for buffers
+   * here, downstream may be holding them until it gets the next image. */
+  while (self->converter.GetPending() < self->converter.GetMaxPending()) {
+    GstBuffer *buf = gst_pylon_acquire_output_buffer(self, false);
+    if (!buf) {
+      break;
+    }
+
+    Pylon::CBaslerUniversalGrabResultPtr *grab_result_ptr =
+        self->image_handler.PollImage();
+    if (!grab_result_ptr) {
+      gst_buffer_unref(buf);
+      break;
+    }
+
+    gst_pylon_submit_conversion(self, grab_result_ptr, buf);
+  }
+
+  bool ok = false;
+  Pylon::CBaslerUniversalGrabResultPtr *grab_result_ptr =
+      self->converter.WaitForResult(converted_buf, &ok);
+  *converted = ok;
+
+  return grab_result_ptr;
 }
 
 static void free_ptr_grab_result(gpointer data) {
@@ -449,6 +924,7 @@ static void free_ptr_grab_result(gpointer data) {
 
 gboolean gst_pylon_capture(GstPylon *self, GstBuffer **buf,
                            GstPylonCaptureErrorEnum capture_error,
+                           GstPylonChunkDecodingEnum chunk_decoding,
                            GError **err) {
   g_return_val_if_fail(self, FALSE);
   g_return_val_if_fail(buf, FALSE);
@@ -459,9 +935,12 @@ gboolean gst_pylon_capture(GstPylon *self, GstBuffer **buf,
   gint retry_frame_counter = 0;
   static const gint max_frames_to_skip = 100;
   Pylon::CBaslerUniversalGrabResultPtr *grab_result_ptr = NULL;
+  GstBuffer *converted_buf = NULL;
+  gboolean converted = FALSE;
 
   while (retry_grab) {
-    grab_result_ptr = self->image_handler.WaitForImage();
+    grab_result_ptr =
+        gst_pylon_wait_for_image(self, &converted_buf, &converted);
 
     /* Return if user requests to interrupt the grabbing thread */
     if (!grab_result_ptr) {
@@ -500,6 +979,9 @@ gboolean gst_pylon_capture(GstPylon *self, GstBuffer **buf,
                               ("%s", error_message.c_str()));
           delete grab_result_ptr;
           grab_result_ptr = NULL;
+          if (converted_buf) {
+            gst_buffer_unref(converted_buf);
+          }
           retry_grab = true;
           retry_frame_counter += 1;
         }
@@ -511,17 +993,69 @@ gboolean gst_pylon_capture(GstPylon *self, GstBuffer **buf,
                   error_message.c_str());
       delete grab_result_ptr;
       grab_result_ptr = NULL;
+      if (converted_buf) {
+        gst_buffer_unref(converted_buf);
+      }
       return FALSE;
     }
   };
 
-  gsize buffer_size = (*grab_result_ptr)->GetBufferSize();
-  *buf = gst_buffer_new_wrapped_full(
-      static_cast<GstMemoryFlags>(0), (*grab_result_ptr)->GetBuffer(),
-      buffer_size, 0, buffer_size, grab_result_ptr,
-      static_cast<GDestroyNotify>(free_ptr_grab_result));
+  /* Packed, debayered and converted formats are written to a separate
+   * buffer so the grab buffer goes straight back to pylon */
+  if (GST_PYLON_UNPACK_NONE != self->unpack_format || self->debayering ||
+      self->converting) {
+    gsize stride =
+        gst_pylon_get_output_stride(self, (*grab_result_ptr)->GetWidth());
+    gboolean ret = FALSE;
+
+    if (self->converting) {
+      *buf = converted_buf;
+      ret = gst_pylon_finish_conversion(*grab_result_ptr, buf, converted);
+    } else {
+      ret = gst_pylon_convert_grab_result(self, *grab_result_ptr, buf);
+    }
+
+    if (ret) {
+      gst_pylon_add_result_meta(self, *buf, *grab_result_ptr, chunk_decoding);
+      GstPylonMeta *meta = reinterpret_cast<GstPylonMeta *>(
+          gst_buffer_get_meta(*buf, GST_PYLON_META_API_TYPE));
+      if (meta) {
+        meta->stride = stride;
+      }
+    } else {
+      g_set_error(err, GST_LIBRARY_ERROR, GST_LIBRARY_ERROR_FAILED,
+                  "Unable to convert a %ux%u image of %zu bytes",
+                  (*grab_result_ptr)->GetWidth(),
+                  (*grab_result_ptr)->GetHeight(),
+                  (*grab_result_ptr)->GetBufferSize());
+    }
+
+    delete grab_result_ptr;
+    return ret;
+  }
+
+  GstFlowReturn pool_ret = gst_pylon_buffer_pool_acquire_grab_result(
+      GST_PYLON_BUFFER_POOL(self->buffer_pool), *grab_result_ptr, buf);
 
-  gst_pylon_add_result_meta(self, *buf, *grab_result_ptr);
+  if (GST_FLOW_OK != pool_ret) {
+    /* The pool is inactive or the image was grabbed into a buffer it does
+     * not own, wrap the grab buffer instead */
+    GST_DEBUG("Wrapping grab buffer, pool returned %s",
+              gst_flow_get_name(pool_ret));
+
+    gsize buffer_size = (*grab_result_ptr)->GetBufferSize();
+    *buf = gst_buffer_new_wrapped_full(
+        static_cast<GstMemoryFlags>(0), (*grab_result_ptr)->GetBuffer(),
+        buffer_size, 0, buffer_size, grab_result_ptr,
+        static_cast<GDestroyNotify>(free_ptr_grab_result));
+  }
+
+  gst_pylon_add_result_meta(self, *buf, *grab_result_ptr, chunk_decoding);
+
+  /* Pooled buffers hold their own reference to the grab result */
+  if (GST_FLOW_OK == pool_ret) {
+    delete grab_result_ptr;
+  }
 
   return TRUE;
 }
@@ -559,13 +1093,45 @@ static std::vector<std::string> gst_pylon_pfnc_list_to_gst(
     std::vector<std::string> gst_fmts =
         gst_pylon_pfnc_to_gst(std::string(genapi_fmt), pixel_format_mapping);
 
-    /* Insert every matching gst format */
-    formats_list.insert(formats_list.end(), gst_fmts.begin(), gst_fmts.end());
+    /* Insert every matching gst format once */
+    for (const auto &gst_fmt : gst_fmts) {
+      if (std::find(formats_list.begin(), formats_list.end(), gst_fmt) ==
+          formats_list.end()) {
+        formats_list.push_back(gst_fmt);
+      }
+    }
   }
 
   return formats_list;
 }
 
+static std::vector<PixelFormatMappingType> gst_pylon_get_format_map(
+    const GstStPixelFormats &gst_structure_format, GstPylonDebayerEnum debayer,
+    gboolean convert) {
+  std::vector<PixelFormatMappingType> format_map =
+      gst_structure_format.format_map;
+
+  /* Formats delivered by the camera come first, so they are preferred over
+   * debayering on the host */
+  if (gst_structure_format.debayer && ENUM_DEBAYER_OFF != debayer) {
+    format_map.insert(format_map.end(), pixel_format_mapping_debayer.begin(),
+                      pixel_format_mapping_debayer.end());
+  }
+
+  if (gst_structure_format.convert && convert) {
+    for (const auto &pfnc_format : pixel_formats_convert) {
+      if (!GstPylonFormatConverter::IsSupported(pfnc_format.c_str())) {
+        continue;
+      }
+      for (const auto &gst_format : pixel_formats_convert_output) {
+        format_map.push_back({pfnc_format, gst_format});
+      }
+    }
+  }
+
+  return format_map;
+}
+
 typedef void (*GstPylonQuery)(GstPylon *, GValue *);
 
 static void gst_pylon_query_format(
@@ -709,7 +1275,9 @@ static void gst_pylon_query_caps(
   self->camera->OffsetY.TrySetValue(orig_offset_y);
 }
 
-GstCaps *gst_pylon_query_configuration(GstPylon *self, GError **err) {
+GstCaps *gst_pylon_query_configuration(GstPylon *self,
+                                       GstPylonDebayerEnum debayer,
+                                       gboolean convert, GError **err) {
   g_return_val_if_fail(self, NULL);
   g_return_val_if_fail(err && *err == NULL, NULL);
 
@@ -720,7 +1288,9 @@ GstCaps *gst_pylon_query_configuration(GstPylon *self, GError **err) {
     GstStructure *st =
         gst_structure_new_empty(gst_structure_format.st_name.c_str());
     try {
-      gst_pylon_query_caps(self, st, gst_structure_format.format_map);
+      gst_pylon_query_caps(
+          self, st,
+          gst_pylon_get_format_map(gst_structure_format, debayer, convert));
       gst_caps_append_structure(caps, st);
     } catch (const Pylon::GenericException &e) {
       gst_structure_free(st);
@@ -736,7 +1306,8 @@ GstCaps *gst_pylon_query_configuration(GstPylon *self, GError **err) {
 }
 
 gboolean gst_pylon_set_configuration(GstPylon *self, const GstCaps *conf,
-                                     GError **err) {
+                                     GstPylonDebayerEnum debayer,
+                                     gboolean convert, GError **err) {
   g_return_val_if_fail(self, FALSE);
   g_return_val_if_fail(conf, FALSE);
   g_return_val_if_fail(err && *err == NULL, FALSE);
@@ -775,15 +1346,42 @@ gboolean gst_pylon_set_configuration(GstPylon *self, const GstCaps *conf,
     }
 
     bool fmt_valid = false;
+    std::string pfnc_format;
+    bool unpack = false;
+    bool msb = false;
+    bool debayer_allowed = false;
+    bool convert_allowed = false;
     for (const auto &gst_structure_format : gst_structure_formats) {
-      const std::vector<std::string> pfnc_formats =
-          gst_pylon_gst_to_pfnc(gst_format, gst_structure_format.format_map);
+      /* The same camera format may be offered by several structures */
+      if (!gst_structure_has_name(st, gst_structure_format.st_name.c_str())) {
+        continue;
+      }
+
+      const std::vector<std::string> pfnc_formats = gst_pylon_gst_to_pfnc(
+          gst_format,
+          gst_pylon_get_format_map(gst_structure_format, debayer, convert));
+      unpack = gst_structure_format.unpack;
+      msb = gst_structure_format.msb;
+      debayer_allowed = gst_structure_format.debayer;
+      convert_allowed = gst_structure_format.convert;
+
+      /* Keep the current format if it already matches, e.g. one chosen by a
+       * PFS file, otherwise in case of ambiguous format mapping choose
+       * first */
+      const std::string current = std::string(pixelformat.GetValue());
+      if (std::find(pfnc_formats.begin(), pfnc_formats.end(), current) !=
+          pfnc_formats.end()) {
+        fmt_valid = true;
+        pfnc_format = current;
+      }
 
-      /* In case of ambiguous format mapping choose first */
       for (auto &fmt : pfnc_formats) {
-        fmt_valid = pixelformat.TrySetValue(fmt.c_str());
         if (fmt_valid) break;
+        fmt_valid = pixelformat.TrySetValue(fmt.c_str());
+        pfnc_format = fmt;
       }
+
+      if (fmt_valid) break;
     }
 
     if (!fmt_valid) {
@@ -792,6 +1390,33 @@ gboolean gst_pylon_set_configuration(GstPylon *self, const GstCaps *conf,
           __FILE__, __LINE__);
     }
 
+    self->unpack_format = unpack
+                              ? gst_pylon_unpack_get_format(pfnc_format.c_str())
+                              : GST_PYLON_UNPACK_NONE;
+    self->unpack_msb = msb;
+
+    /* Bayer formats are only offered as raw video for debayering */
+    GstPylonDebayerPattern pattern = GST_PYLON_DEBAYER_PATTERN_RGGB;
+    GstPylonDebayerOutput output = GST_PYLON_DEBAYER_OUTPUT_RGB;
+    self->debayering =
+        debayer_allowed &&
+        GstPylonDebayer::GetPattern(pfnc_format.c_str(), &pattern) &&
+        GstPylonDebayer::GetOutput(gst_format.c_str(), &output);
+    if (self->debayering) {
+      self->debayer.SetFormat(pattern,
+                              ENUM_DEBAYER_HIGH_QUALITY == debayer
+                                  ? GST_PYLON_DEBAYER_HIGH_QUALITY
+                                  : GST_PYLON_DEBAYER_BILINEAR,
+                              output);
+    }
+
+    /* Formats pylon converts have no native mapping */
+    self->converting =
+        convert_allowed && convert &&
+        std::find(pixel_formats_convert.begin(), pixel_formats_convert.end(),
+                  pfnc_format) != pixel_formats_convert.end() &&
+        self->converter.SetFormat(gst_format.c_str());
+
     Pylon::CIntegerParameter width(nodemap, "Width");
     width.SetValue(gst_width, Pylon::IntegerValueCorrection_None);
 
@@ -831,7 +1456,9 @@ static void gst_pylon_append_properties(
   g_return_if_fail(camera);
   g_return_if_fail(device_properties);
 
-  GType device_type = gst_pylon_object_register(device_full_name, nodemap);
+  GType device_type = gst_pylon_object_register(
+      device_full_name, gst_pylon_get_cache_name(*camera, device_type_str),
+      nodemap);
   GObject *device_obj = G_OBJECT(g_object_new(device_type, NULL));
 
   gchar *device_name = g_strdup_printf(
@@ -862,7 +1489,7 @@ static void gst_pylon_append_camera_properties(
 
   GenApi::INodeMap &nodemap = camera->GetNodeMap();
   Pylon::String_t camera_name = gst_pylon_get_camera_fullname(*camera);
-  Pylon::String_t device_type = "Camera";
+  Pylon::String_t device_type = CAMERA_DEVICE_TYPE;
 
   gst_pylon_append_properties(camera, camera_name, device_type, nodemap,
                               camera_properties, alignment);
@@ -877,44 +1504,93 @@ static void gst_pylon_append_stream_grabber_properties(
   GenApi::INodeMap &nodemap = camera->GetStreamGrabberNodeMap();
   ;
   Pylon::String_t sgrabber_name = gst_pylon_get_sgrabber_name(*camera);
-  Pylon::String_t device_type = "Stream Grabber";
+  Pylon::String_t device_type = SGRABBER_DEVICE_TYPE;
 
   gst_pylon_append_properties(camera, sgrabber_name, device_type, nodemap,
                               sgrabber_properties, alignment);
 }
 
-static gchar *gst_pylon_get_string_properties(
-    GetStringProperties get_device_string_properties) {
-  gchar *camera_properties = NULL;
+void gst_pylon_get_string_properties(gchar **camera_properties,
+                                     gchar **sgrabber_properties) {
+  g_return_if_fail(camera_properties);
+  g_return_if_fail(sgrabber_properties);
 
   Pylon::CTlFactory &factory = Pylon::CTlFactory::GetInstance();
   Pylon::DeviceInfoList_t device_list;
 
   factory.EnumerateDevices(device_list);
 
-  for (const auto &device : device_list) {
-    try {
-      Pylon::CBaslerUniversalInstantCamera camera(factory.CreateDevice(device),
-                                                  Pylon::Cleanup_Delete);
-      camera.Open();
-      get_device_string_properties(&camera, &camera_properties,
-                                   DEFAULT_ALIGNMENT);
-      camera.Close();
-    } catch (const Pylon::GenericException &) {
-      continue;
+  /* Opening a device and querying the access of its features is dominated
+   * by the device I/O, so the devices are opened and their feature caches
+   * filled concurrently. The type registration and class init are
+   * serialized by GLib anyway, they run afterwards on this thread and only
+   * read the filled caches. Devices of the same model share a cache, which
+   * is only filled by one of them. */
+  std::vector<std::shared_ptr<Pylon::CBaslerUniversalInstantCamera>> cameras(
+      device_list.size());
+  std::set<std::string> claimed_caches;
+  std::mutex claimed_caches_mutex;
+  std::atomic<gsize> next_device(0);
+
+  auto claim_cache = [&](const std::string &cache_name) {
+    std::lock_guard<std::mutex> lock(claimed_caches_mutex);
+    return claimed_caches.insert(cache_name).second;
+  };
+
+  auto worker = [&]() {
+    for (gsize i = next_device++; i < device_list.size(); i = next_device++) {
+      try {
+        auto camera = std::make_shared<Pylon::CBaslerUniversalInstantCamera>(
+            factory.CreateDevice(device_list[i]), Pylon::Cleanup_Delete);
+        camera->Open();
+        cameras[i] = camera;
+
+        std::string cache_name =
+            gst_pylon_get_cache_name(*camera, CAMERA_DEVICE_TYPE);
+        if (claim_cache(cache_name)) {
+          gst_pylon_object_fill_cache(gst_pylon_get_camera_fullname(*camera),
+                                      cache_name, camera->GetNodeMap());
+        }
+
+        cache_name = gst_pylon_get_cache_name(*camera, SGRABBER_DEVICE_TYPE);
+        if (claim_cache(cache_name)) {
+          gst_pylon_object_fill_cache(gst_pylon_get_sgrabber_name(*camera),
+                                      cache_name,
+                                      camera->GetStreamGrabberNodeMap());
+        }
+      } catch (const Pylon::GenericException &e) {
+        GST_DEBUG("Unable to explore device \"%s\": %s",
+                  device_list[i].GetFullName().c_str(), e.GetDescription());
+      }
     }
-  }
+  };
 
-  return camera_properties;
-}
+  gsize n_workers = MIN(device_list.size(), MAX_INTROSPECTION_WORKERS);
+  std::vector<std::thread> workers;
+  for (gsize i = 0; i < n_workers; i++) {
+    workers.emplace_back(worker);
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
 
-gchar *gst_pylon_camera_get_string_properties() {
-  return gst_pylon_get_string_properties(gst_pylon_append_camera_properties);
-}
+  /* Keep the enumeration order in the resulting lists */
+  for (gsize i = 0; i < device_list.size(); i++) {
+    if (!cameras[i]) {
+      continue;
+    }
 
-gchar *gst_pylon_stream_grabber_get_string_properties() {
-  return gst_pylon_get_string_properties(
-      gst_pylon_append_stream_grabber_properties);
+    try {
+      gst_pylon_append_camera_properties(cameras[i].get(), camera_properties,
+                                         DEFAULT_ALIGNMENT);
+      gst_pylon_append_stream_grabber_properties(
+          cameras[i].get(), sgrabber_properties, DEFAULT_ALIGNMENT);
+      cameras[i]->Close();
+    } catch (const Pylon::GenericException &e) {
+      GST_DEBUG("Unable to introspect device \"%s\": %s",
+                device_list[i].GetFullName().c_str(), e.GetDescription());
+    }
+  }
 }
 
 GObject *gst_pylon_get_camera(GstPylon *self) {
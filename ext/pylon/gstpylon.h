@@ -46,6 +46,30 @@ typedef enum {
   ENUM_ABORT = 2,
 } GstPylonCaptureErrorEnum;
 
+typedef enum {
+  ENUM_ONE_BY_ONE = 0,
+  ENUM_LATEST_IMAGE_ONLY = 1,
+  ENUM_LATEST_IMAGES = 2,
+} GstPylonGrabStrategyEnum;
+
+typedef enum {
+  ENUM_TIMESTAMP_PIPELINE_CLOCK = 0,
+  ENUM_TIMESTAMP_CAMERA = 1,
+  ENUM_TIMESTAMP_CAMERA_CORRELATED = 2,
+} GstPylonTimestampModeEnum;
+
+typedef enum {
+  ENUM_CHUNKS_EAGER = 0,
+  ENUM_CHUNKS_LAZY = 1,
+  ENUM_CHUNKS_OFF = 2,
+} GstPylonChunkDecodingEnum;
+
+typedef enum {
+  ENUM_DEBAYER_OFF = 0,
+  ENUM_DEBAYER_BILINEAR = 1,
+  ENUM_DEBAYER_HIGH_QUALITY = 2,
+} GstPylonDebayerEnum;
+
 void gst_pylon_initialize();
 
 GstPylon *gst_pylon_new(GstElement *gstpylonsrc, const gchar *device_user_name,
@@ -55,21 +79,34 @@ gboolean gst_pylon_set_user_config(GstPylon *self, const gchar *user_set,
                                    GError **err);
 void gst_pylon_free(GstPylon *self);
 
-gboolean gst_pylon_start(GstPylon *self, GError **err);
+gboolean gst_pylon_start(GstPylon *self, guint queue_depth,
+                         GstPylonGrabStrategyEnum grab_strategy,
+                         guint output_queue_size, guint max_num_buffer,
+                         GError **err);
 gboolean gst_pylon_stop(GstPylon *self, GError **err);
 void gst_pylon_interrupt_capture(GstPylon *self);
+guint64 gst_pylon_get_dropped_images(GstPylon *self);
+guint gst_pylon_get_max_queued_images(GstPylon *self);
+GstBufferPool *gst_pylon_get_buffer_pool(GstPylon *self);
+gboolean gst_pylon_latch_timestamp(GstPylon *self, guint64 *timestamp,
+                                   GError **err);
+guint64 gst_pylon_get_timestamp_frequency(GstPylon *self);
 gboolean gst_pylon_capture(GstPylon *self, GstBuffer **buf,
                            GstPylonCaptureErrorEnum capture_error,
+                           GstPylonChunkDecodingEnum chunk_decoding,
                            GError **err);
-GstCaps *gst_pylon_query_configuration(GstPylon *self, GError **err);
+GstCaps *gst_pylon_query_configuration(GstPylon *self,
+                                       GstPylonDebayerEnum debayer,
+                                       gboolean convert, GError **err);
 gboolean gst_pylon_get_startup_geometry(GstPylon *self, gint *start_width,
                                         gint *start_height);
 gboolean gst_pylon_set_configuration(GstPylon *self, const GstCaps *conf,
-                                     GError **err);
+                                     GstPylonDebayerEnum debayer,
+                                     gboolean convert, GError **err);
 gboolean gst_pylon_set_pfs_config(GstPylon *self, const gchar *pfs_location,
                                   GError **err);
-gchar *gst_pylon_camera_get_string_properties();
-gchar *gst_pylon_stream_grabber_get_string_properties();
+void gst_pylon_get_string_properties(gchar **camera_properties,
+                                     gchar **sgrabber_properties);
 
 GObject *gst_pylon_get_camera(GstPylon *self);
 GObject *gst_pylon_get_stream_grabber(GstPylon *self);
@@ -0,0 +1,376 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstpylonbufferpool.h"
+
+#include "gst/pylon/gstpylondebug.h"
+
+#include <gst/allocators/allocators.h>
+
+/* Subclass flag signaling that the acquire params carry a grab result */
+#define GST_PYLON_BUFFER_POOL_ACQUIRE_FLAG_GRAB_RESULT \
+  ((GstBufferPoolAcquireFlags)GST_BUFFER_POOL_ACQUIRE_FLAG_LAST)
+
+typedef struct _GstPylonBufferPoolAcquireParams
+    GstPylonBufferPoolAcquireParams;
+struct _GstPylonBufferPoolAcquireParams {
+  GstBufferPoolAcquireParams parent;
+  const Pylon::CBaslerUniversalGrabResultPtr *grab_result;
+};
+
+/* Every pylon grab buffer is backed by one GstBuffer that lives as long as
+ * pylon keeps the grab buffer allocated. While idle the slot owns the
+ * GstBuffer, while the image is in the pipeline the slot owns the grab
+ * result so pylon does not requeue the memory. */
+typedef struct _GstPylonBufferSlot GstPylonBufferSlot;
+struct _GstPylonBufferSlot {
+  GstBuffer *buffer;
+  GstMemory *memory;
+  GstMapInfo map;
+  Pylon::CBaslerUniversalGrabResultPtr grab_result;
+};
+
+class GstPylonBufferFactory : public Pylon::IBufferFactory {
+ public:
+  GstPylonBufferFactory();
+  ~GstPylonBufferFactory();
+  /* Must only be called while pylon is not allocating buffers */
+  void SetAllocator(GstAllocator *allocator, const GstAllocationParams *params);
+  void AllocateBuffer(size_t buffer_size, void **created_buffer,
+                      intptr_t &buffer_context) override;
+  void FreeBuffer(void *created_buffer, intptr_t buffer_context) override;
+  void DestroyBufferFactory() override;
+
+ private:
+  GstAllocator *allocator;
+  GstAllocationParams params;
+
+  GstMemory *AllocateMemory(size_t buffer_size, GstMapInfo *map);
+};
+
+struct _GstPylonBufferPool {
+  GstBufferPool base;
+  GstPylonBufferFactory *factory;
+};
+
+G_DEFINE_TYPE(GstPylonBufferPool, gst_pylon_buffer_pool, GST_TYPE_BUFFER_POOL);
+
+static gboolean gst_pylon_buffer_pool_start(GstBufferPool *pool);
+static gboolean gst_pylon_buffer_pool_stop(GstBufferPool *pool);
+static gboolean gst_pylon_buffer_pool_set_config(GstBufferPool *pool,
+                                                 GstStructure *config);
+static GstFlowReturn gst_pylon_buffer_pool_alloc_buffer(
+    GstBufferPool *pool, GstBuffer **buf, GstBufferPoolAcquireParams *params);
+static GstFlowReturn gst_pylon_buffer_pool_acquire_buffer(
+    GstBufferPool *pool, GstBuffer **buf, GstBufferPoolAcquireParams *params);
+static void gst_pylon_buffer_pool_release_buffer(GstBufferPool *pool,
+                                                 GstBuffer *buf);
+static void gst_pylon_buffer_pool_finalize(GObject *object);
+
+static GQuark gst_pylon_buffer_slot_quark(void) {
+  static GQuark quark = g_quark_from_static_string("GstPylonBufferSlot");
+
+  return quark;
+}
+
+GstPylonBufferFactory::GstPylonBufferFactory() : allocator(NULL) {
+  gst_allocation_params_init(&this->params);
+}
+
+GstPylonBufferFactory::~GstPylonBufferFactory() {
+  if (this->allocator) {
+    gst_object_unref(this->allocator);
+  }
+}
+
+void GstPylonBufferFactory::SetAllocator(GstAllocator *allocator,
+                                         const GstAllocationParams *params) {
+  if (allocator) {
+    gst_object_ref(allocator);
+  }
+  if (this->allocator) {
+    gst_object_unref(this->allocator);
+  }
+  this->allocator = allocator;
+
+  if (params) {
+    this->params = *params;
+  } else {
+    gst_allocation_params_init(&this->params);
+  }
+}
+
+/* Pylon writes into the grab buffers through a mapping kept for their whole
+ * lifetime, without syncing around each grab. That is only coherent for
+ * memory the CPU accesses directly, i.e. system memory and plain fd memory
+ * like memfd or shm. dmabuf would require a sync around every write. */
+static gboolean gst_pylon_buffer_factory_can_keep_mapped(GstMemory *memory) {
+  if (gst_is_dmabuf_memory(memory)) {
+    return FALSE;
+  }
+
+  return gst_is_fd_memory(memory) ||
+         gst_memory_is_type(memory, GST_ALLOCATOR_SYSMEM);
+}
+
+GstMemory *GstPylonBufferFactory::AllocateMemory(size_t buffer_size,
+                                                 GstMapInfo *map) {
+  GstMemory *memory = NULL;
+
+  /* Allocators with a custom allocation function can't be used through
+   * gst_allocator_alloc */
+  if (this->allocator &&
+      !GST_OBJECT_FLAG_IS_SET(this->allocator,
+                              GST_ALLOCATOR_FLAG_CUSTOM_ALLOC)) {
+    memory = gst_allocator_alloc(this->allocator, buffer_size, &this->params);
+  }
+
+  if (memory && !gst_pylon_buffer_factory_can_keep_mapped(memory)) {
+    gst_memory_unref(memory);
+    memory = NULL;
+  }
+
+  /* Pylon writes into the buffer for as long as it is allocated, keep it
+   * mapped until it is freed */
+  if (memory && !gst_memory_map(memory, map, GST_MAP_READWRITE)) {
+    gst_memory_unref(memory);
+    memory = NULL;
+  }
+
+  if (!memory) {
+    if (this->allocator) {
+      GST_DEBUG_OBJECT(this->allocator,
+                       "Unable to grab into memory of this allocator, "
+                       "falling back to system memory");
+    }
+
+    memory = gst_allocator_alloc(NULL, buffer_size, &this->params);
+    if (memory && !gst_memory_map(memory, map, GST_MAP_READWRITE)) {
+      gst_memory_unref(memory);
+      memory = NULL;
+    }
+  }
+
+  return memory;
+}
+
+void GstPylonBufferFactory::AllocateBuffer(size_t buffer_size,
+                                           void **created_buffer,
+                                           intptr_t &buffer_context) {
+  GstPylonBufferSlot *slot = new GstPylonBufferSlot;
+
+  slot->memory = this->AllocateMemory(buffer_size, &slot->map);
+  if (!slot->memory) {
+    delete slot;
+    throw RUNTIME_EXCEPTION("Unable to allocate a %zu byte grab buffer",
+                            buffer_size);
+  }
+
+  slot->buffer = gst_buffer_new();
+  gst_buffer_append_memory(slot->buffer, gst_memory_ref(slot->memory));
+  gst_mini_object_set_qdata(GST_MINI_OBJECT(slot->buffer),
+                            gst_pylon_buffer_slot_quark(), slot, NULL);
+
+  *created_buffer = slot->map.data;
+  buffer_context = reinterpret_cast<intptr_t>(slot);
+}
+
+void GstPylonBufferFactory::FreeBuffer(void *created_buffer,
+                                       intptr_t buffer_context) {
+  GstPylonBufferSlot *slot =
+      reinterpret_cast<GstPylonBufferSlot *>(buffer_context);
+
+  g_return_if_fail(slot);
+  g_return_if_fail(created_buffer == slot->map.data);
+
+  gst_memory_unmap(slot->memory, &slot->map);
+  gst_memory_unref(slot->memory);
+  gst_buffer_unref(slot->buffer);
+
+  delete slot;
+}
+
+/* The factory is owned by the pool, nothing to do here */
+void GstPylonBufferFactory::DestroyBufferFactory() {}
+
+static void gst_pylon_buffer_pool_class_init(GstPylonBufferPoolClass *klass) {
+  GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+  GstBufferPoolClass *pool_class = GST_BUFFER_POOL_CLASS(klass);
+
+  gobject_class->finalize = gst_pylon_buffer_pool_finalize;
+
+  pool_class->set_config = gst_pylon_buffer_pool_set_config;
+  pool_class->start = gst_pylon_buffer_pool_start;
+  pool_class->stop = gst_pylon_buffer_pool_stop;
+  pool_class->alloc_buffer = gst_pylon_buffer_pool_alloc_buffer;
+  pool_class->acquire_buffer = gst_pylon_buffer_pool_acquire_buffer;
+  pool_class->release_buffer = gst_pylon_buffer_pool_release_buffer;
+}
+
+static void gst_pylon_buffer_pool_init(GstPylonBufferPool *self) {
+  self->factory = new GstPylonBufferFactory;
+}
+
+static void gst_pylon_buffer_pool_finalize(GObject *object) {
+  GstPylonBufferPool *self = GST_PYLON_BUFFER_POOL(object);
+
+  delete self->factory;
+
+  G_OBJECT_CLASS(gst_pylon_buffer_pool_parent_class)->finalize(object);
+}
+
+static gboolean gst_pylon_buffer_pool_set_config(GstBufferPool *pool,
+                                                 GstStructure *config) {
+  GstPylonBufferPool *self = GST_PYLON_BUFFER_POOL(pool);
+  GstAllocator *allocator = NULL;
+  GstAllocationParams params;
+
+  if (!gst_buffer_pool_config_get_allocator(config, &allocator, &params)) {
+    GST_WARNING_OBJECT(pool, "Invalid buffer pool configuration");
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT(pool, "Grabbing into memory from %" GST_PTR_FORMAT,
+                   allocator);
+  self->factory->SetAllocator(allocator, &params);
+
+  return GST_BUFFER_POOL_CLASS(gst_pylon_buffer_pool_parent_class)
+      ->set_config(pool, config);
+}
+
+/* Buffers are allocated by pylon when grabbing starts, so there is nothing
+ * to preallocate or free when the pool is (de)activated */
+static gboolean gst_pylon_buffer_pool_start(GstBufferPool *pool) {
+  return TRUE;
+}
+
+static gboolean gst_pylon_buffer_pool_stop(GstBufferPool *pool) {
+  return TRUE;
+}
+
+static GstFlowReturn gst_pylon_buffer_pool_alloc_buffer(
+    GstBufferPool *pool, GstBuffer **buf, GstBufferPoolAcquireParams *params) {
+  GST_ERROR_OBJECT(pool, "Buffers can only be acquired from grab results");
+
+  return GST_FLOW_NOT_SUPPORTED;
+}
+
+static GstFlowReturn gst_pylon_buffer_pool_acquire_buffer(
+    GstBufferPool *pool, GstBuffer **buf, GstBufferPoolAcquireParams *params) {
+  GstPylonBufferPoolAcquireParams *pylon_params =
+      reinterpret_cast<GstPylonBufferPoolAcquireParams *>(params);
+
+  if (!params ||
+      !(params->flags & GST_PYLON_BUFFER_POOL_ACQUIRE_FLAG_GRAB_RESULT)) {
+    return gst_pylon_buffer_pool_alloc_buffer(pool, buf, params);
+  }
+
+  /* The base class checks this before acquiring, the override has to do it
+   * itself. The caller wraps the grab buffer instead. */
+  if (!gst_buffer_pool_is_active(pool)) {
+    return GST_FLOW_FLUSHING;
+  }
+
+  const Pylon::CBaslerUniversalGrabResultPtr &grab_result =
+      *pylon_params->grab_result;
+  GstPylonBufferSlot *slot =
+      reinterpret_cast<GstPylonBufferSlot *>(grab_result->GetBufferContext());
+
+  /* The grab buffer was not allocated by this pool */
+  if (!slot || slot->map.data != grab_result->GetBuffer()) {
+    return GST_FLOW_NOT_SUPPORTED;
+  }
+
+  /* Hand the slot reference over to the caller and keep the grab buffer
+   * until the GstBuffer returns to the pool */
+  slot->grab_result = grab_result;
+  *buf = slot->buffer;
+
+  return GST_FLOW_OK;
+}
+
+static void gst_pylon_buffer_pool_release_buffer(GstBufferPool *pool,
+                                                 GstBuffer *buf) {
+  GstPylonBufferSlot *slot = static_cast<GstPylonBufferSlot *>(
+      gst_mini_object_get_qdata(GST_MINI_OBJECT(buf),
+                                gst_pylon_buffer_slot_quark()));
+
+  g_return_if_fail(slot);
+
+  /* Undo changes downstream made to the memory layout */
+  if (GST_BUFFER_FLAG_IS_SET(buf, GST_BUFFER_FLAG_TAG_MEMORY)) {
+    gst_buffer_replace_all_memory(buf, gst_memory_ref(slot->memory));
+    GST_BUFFER_FLAG_UNSET(buf, GST_BUFFER_FLAG_TAG_MEMORY);
+  }
+  if (gst_buffer_get_size(buf) != slot->map.size) {
+    gst_buffer_set_size(buf, slot->map.size);
+  }
+
+  /* The buffer comes back with a single reference, which belongs to the
+   * slot again. Releasing the grab result lets pylon requeue the grab
+   * buffer, or free the slot if grabbing already stopped, so the slot must
+   * not be touched afterwards. */
+  Pylon::CBaslerUniversalGrabResultPtr grab_result = slot->grab_result;
+  slot->grab_result.Release();
+  grab_result.Release();
+}
+
+GstBufferPool *gst_pylon_buffer_pool_new(void) {
+  return GST_BUFFER_POOL(g_object_new(GST_TYPE_PYLON_BUFFER_POOL, NULL));
+}
+
+Pylon::IBufferFactory *gst_pylon_buffer_pool_get_buffer_factory(
+    GstPylonBufferPool *self) {
+  g_return_val_if_fail(GST_IS_PYLON_BUFFER_POOL(self), NULL);
+
+  return self->factory;
+}
+
+GstFlowReturn gst_pylon_buffer_pool_acquire_grab_result(
+    GstPylonBufferPool *self,
+    const Pylon::CBaslerUniversalGrabResultPtr &grab_result, GstBuffer **buf) {
+  GstPylonBufferPoolAcquireParams params = {};
+
+  g_return_val_if_fail(GST_IS_PYLON_BUFFER_POOL(self), GST_FLOW_ERROR);
+  g_return_val_if_fail(buf, GST_FLOW_ERROR);
+
+  params.parent.flags = GST_PYLON_BUFFER_POOL_ACQUIRE_FLAG_GRAB_RESULT;
+  params.grab_result = &grab_result;
+
+  return gst_buffer_pool_acquire_buffer(
+      GST_BUFFER_POOL(self), buf,
+      reinterpret_cast<GstBufferPoolAcquireParams *>(&params));
+}
@@ -0,0 +1,683 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstpylondebayer.h"
+#include "gstpylonsimd.h"
+
+#include <cstring>
+
+/* An image is converted by at most this many threads, the caller included */
+static constexpr guint MAX_DEBAYER_BANDS = 8;
+/* Waking a worker for fewer rows costs more than it saves */
+static constexpr guint MIN_BAND_HEIGHT = 32;
+/* The interpolation reads up to two samples away on each side */
+static constexpr guint BORDER = 2;
+
+/* Color of a sample, green samples are told apart by the color next to them
+ * on the same row */
+typedef enum {
+  KIND_R = 0,
+  KIND_GR = 1,
+  KIND_GB = 2,
+  KIND_B = 3,
+} GstPylonDebayerKind;
+
+/* Values interpolated for every pixel, which one ends up in each channel
+ * depends on the color of the sample */
+enum {
+  /* The sample itself */
+  CANDIDATE_CENTER = 0,
+  /* Green at a red or blue sample */
+  CANDIDATE_GREEN = 1,
+  /* Color of the horizontal neighbors at a green sample */
+  CANDIDATE_HORIZONTAL = 2,
+  /* Color of the vertical neighbors at a green sample */
+  CANDIDATE_VERTICAL = 3,
+  /* Color of the diagonal neighbors at a red or blue sample */
+  CANDIDATE_DIAGONAL = 4,
+  N_CANDIDATES = 5
+};
+
+/* Candidate used for the red, green and blue channels of each kind */
+static const guint8 kind_candidates[4][3] = {
+    {CANDIDATE_CENTER, CANDIDATE_GREEN, CANDIDATE_DIAGONAL},
+    {CANDIDATE_HORIZONTAL, CANDIDATE_CENTER, CANDIDATE_VERTICAL},
+    {CANDIDATE_VERTICAL, CANDIDATE_CENTER, CANDIDATE_HORIZONTAL},
+    {CANDIDATE_DIAGONAL, CANDIDATE_GREEN, CANDIDATE_CENTER}};
+
+/* Kinds of the even and odd samples of the even and odd rows */
+static const GstPylonDebayerKind pattern_kinds[4][2][2] = {
+    {{KIND_R, KIND_GR}, {KIND_GB, KIND_B}},
+    {{KIND_B, KIND_GB}, {KIND_GR, KIND_R}},
+    {{KIND_GR, KIND_R}, {KIND_B, KIND_GB}},
+    {{KIND_GB, KIND_B}, {KIND_R, KIND_GR}}};
+
+typedef struct {
+  const gchar *pfnc_name;
+  GstPylonDebayerPattern pattern;
+} GstPylonDebayerPatternInfo;
+
+static const GstPylonDebayerPatternInfo debayer_patterns[] = {
+    {"BayerRG8", GST_PYLON_DEBAYER_PATTERN_RGGB},
+    {"BayerBG8", GST_PYLON_DEBAYER_PATTERN_BGGR},
+    {"BayerGR8", GST_PYLON_DEBAYER_PATTERN_GRBG},
+    {"BayerGB8", GST_PYLON_DEBAYER_PATTERN_GBRG},
+};
+
+typedef struct {
+  const gchar *gst_format;
+  GstPylonDebayerOutput output;
+  guint pixel_stride;
+} GstPylonDebayerOutputInfo;
+
+static const GstPylonDebayerOutputInfo debayer_outputs[] = {
+    {"RGB", GST_PYLON_DEBAYER_OUTPUT_RGB, 3},
+    {"BGRx", GST_PYLON_DEBAYER_OUTPUT_BGRX, 4},
+    {"GRAY8", GST_PYLON_DEBAYER_OUTPUT_GRAY8, 1},
+};
+
+/* prototypes */
+static inline gint gst_pylon_debayer_reflect(gint i, gint size);
+static void gst_pylon_debayer_pixel(const guint8 *src, gsize src_stride,
+                                    gint width, gint height, gint x, gint y,
+                                    GstPylonDebayerMethod method,
+                                    gint candidates[N_CANDIDATES]);
+static inline void gst_pylon_debayer_store(GstPylonDebayerOutput output,
+                                           guint8 *dst, guint x, gint r,
+                                           gint g, gint b);
+static void gst_pylon_debayer_row(const guint8 *src, gsize src_stride,
+                                  guint width, guint height, guint y,
+                                  guint8 *dst, GstPylonDebayerPattern pattern,
+                                  GstPylonDebayerMethod method,
+                                  GstPylonDebayerOutput output);
+
+/* Mirroring around the border sample keeps the Bayer parity */
+static inline gint gst_pylon_debayer_reflect(gint i, gint size) {
+  if (i < 0) {
+    i = -i;
+  }
+  if (i >= size) {
+    i = 2 * (size - 1) - i;
+  }
+
+  return CLAMP(i, 0, size - 1);
+}
+
+/* Computes the candidates of a single pixel with the image mirrored past its
+ * borders. The arithmetic matches the vector kernels exactly. */
+static void gst_pylon_debayer_pixel(const guint8 *src, gsize src_stride,
+                                    gint width, gint height, gint x, gint y,
+                                    GstPylonDebayerMethod method,
+                                    gint candidates[N_CANDIDATES]) {
+  auto at = [&](gint dx, gint dy) -> gint {
+    return src[gst_pylon_debayer_reflect(y + dy, height) * src_stride +
+               gst_pylon_debayer_reflect(x + dx, width)];
+  };
+
+  gint c = at(0, 0);
+  gint hz = at(-1, 0) + at(1, 0);
+  gint vt = at(0, -1) + at(0, 1);
+  gint diag = at(-1, -1) + at(1, -1) + at(-1, 1) + at(1, 1);
+
+  candidates[CANDIDATE_CENTER] = c;
+
+  if (GST_PYLON_DEBAYER_BILINEAR == method) {
+    candidates[CANDIDATE_GREEN] = (hz + vt + 2) >> 2;
+    candidates[CANDIDATE_HORIZONTAL] = (hz + 1) >> 1;
+    candidates[CANDIDATE_VERTICAL] = (vt + 1) >> 1;
+    candidates[CANDIDATE_DIAGONAL] = (diag + 2) >> 2;
+    return;
+  }
+
+  gint far_h = at(-2, 0) + at(2, 0);
+  gint far_v = at(0, -2) + at(0, 2);
+
+  /* Malvar-He-Cutler kernels scaled by 16 */
+  candidates[CANDIDATE_GREEN] =
+      (8 * c + 4 * (hz + vt) - 2 * (far_h + far_v) + 8) >> 4;
+  candidates[CANDIDATE_HORIZONTAL] =
+      (10 * c + 8 * hz - 2 * diag - 2 * far_h + far_v + 8) >> 4;
+  candidates[CANDIDATE_VERTICAL] =
+      (10 * c + 8 * vt - 2 * diag - 2 * far_v + far_h + 8) >> 4;
+  candidates[CANDIDATE_DIAGONAL] =
+      (12 * c + 4 * diag - 3 * (far_h + far_v) + 8) >> 4;
+}
+
+static inline void gst_pylon_debayer_store(GstPylonDebayerOutput output,
+                                           guint8 *dst, guint x, gint r,
+                                           gint g, gint b) {
+  r = CLAMP(r, 0, 255);
+  g = CLAMP(g, 0, 255);
+  b = CLAMP(b, 0, 255);
+
+  switch (output) {
+    case GST_PYLON_DEBAYER_OUTPUT_RGB:
+      dst[3 * x] = r;
+      dst[3 * x + 1] = g;
+      dst[3 * x + 2] = b;
+      break;
+    case GST_PYLON_DEBAYER_OUTPUT_BGRX:
+      dst[4 * x] = b;
+      dst[4 * x + 1] = g;
+      dst[4 * x + 2] = r;
+      dst[4 * x + 3] = 0xff;
+      break;
+    case GST_PYLON_DEBAYER_OUTPUT_GRAY8:
+      /* BT.601 luma */
+      dst[x] = (77 * r + 150 * g + 29 * b + 128) >> 8;
+      break;
+  }
+}
+
+#ifdef GST_PYLON_SIMD_AVX2
+__attribute__((target("avx2"))) static inline __m256i
+gst_pylon_debayer_load_avx2(const guint8 *src) {
+  return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)src));
+}
+
+__attribute__((target("avx2"))) static inline __m128i
+gst_pylon_debayer_narrow_avx2(__m256i v) {
+  return _mm_packus_epi16(_mm256_castsi256_si128(v),
+                          _mm256_extracti128_si256(v, 1));
+}
+
+/* Converts 16 pixels at a time with every candidate computed for every
+ * pixel, even and odd pixels then pick their channels with a blend. The RGB
+ * stores spill 4 bytes into the next pixels, so the kernel stops at least
+ * two pixels before the end of the row. Returns the first pixel left. */
+__attribute__((target("avx2"))) static guint gst_pylon_debayer_row_avx2(
+    const guint8 *const rows[5], guint8 *dst, guint x, guint end,
+    const guint8 *even, const guint8 *odd, GstPylonDebayerMethod method,
+    GstPylonDebayerOutput output) {
+  const __m256i odd_mask = _mm256_set1_epi32((gint)0xffff0000);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i max = _mm256_set1_epi16(255);
+  const __m256i one = _mm256_set1_epi16(1);
+  const __m256i two = _mm256_set1_epi16(2);
+  const __m256i eight = _mm256_set1_epi16(8);
+  const __m128i opaque = _mm_set1_epi8((char)0xff);
+  const __m128i rgb_shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12,
+                                            13, 14, -1, -1, -1, -1);
+
+  for (; x + 16 <= end; x += 16) {
+    const guint8 *up = rows[1] + x;
+    const guint8 *mid = rows[2] + x;
+    const guint8 *down = rows[3] + x;
+    __m256i candidates[N_CANDIDATES];
+
+    __m256i c = gst_pylon_debayer_load_avx2(mid);
+    __m256i hz = _mm256_add_epi16(gst_pylon_debayer_load_avx2(mid - 1),
+                                  gst_pylon_debayer_load_avx2(mid + 1));
+    __m256i vt = _mm256_add_epi16(gst_pylon_debayer_load_avx2(up),
+                                  gst_pylon_debayer_load_avx2(down));
+    __m256i diag = _mm256_add_epi16(
+        _mm256_add_epi16(gst_pylon_debayer_load_avx2(up - 1),
+                         gst_pylon_debayer_load_avx2(up + 1)),
+        _mm256_add_epi16(gst_pylon_debayer_load_avx2(down - 1),
+                         gst_pylon_debayer_load_avx2(down + 1)));
+
+    candidates[CANDIDATE_CENTER] = c;
+
+    if (GST_PYLON_DEBAYER_BILINEAR == method) {
+      candidates[CANDIDATE_GREEN] = _mm256_srli_epi16(
+          _mm256_add_epi16(_mm256_add_epi16(hz, vt), two), 2);
+      candidates[CANDIDATE_HORIZONTAL] =
+          _mm256_srli_epi16(_mm256_add_epi16(hz, one), 1);
+      candidates[CANDIDATE_VERTICAL] =
+          _mm256_srli_epi16(_mm256_add_epi16(vt, one), 1);
+      candidates[CANDIDATE_DIAGONAL] =
+          _mm256_srli_epi16(_mm256_add_epi16(diag, two), 2);
+    } else {
+      __m256i far_h = _mm256_add_epi16(gst_pylon_debayer_load_avx2(mid - 2),
+                                       gst_pylon_debayer_load_avx2(mid + 2));
+      __m256i far_v =
+          _mm256_add_epi16(gst_pylon_debayer_load_avx2(rows[0] + x),
+                           gst_pylon_debayer_load_avx2(rows[4] + x));
+      __m256i far = _mm256_add_epi16(far_h, far_v);
+      __m256i c5 = _mm256_add_epi16(_mm256_slli_epi16(c, 2), c);
+      __m256i t;
+
+      /* 8c + 4(hz + vt) - 2far */
+      t = _mm256_slli_epi16(
+          _mm256_add_epi16(_mm256_slli_epi16(c, 1), _mm256_add_epi16(hz, vt)),
+          2);
+      t = _mm256_sub_epi16(t, _mm256_slli_epi16(far, 1));
+      candidates[CANDIDATE_GREEN] =
+          _mm256_srai_epi16(_mm256_add_epi16(t, eight), 4);
+
+      /* 2(5c + 4hz - diag - far_h) + far_v */
+      t = _mm256_add_epi16(c5, _mm256_slli_epi16(hz, 2));
+      t = _mm256_sub_epi16(_mm256_sub_epi16(t, diag), far_h);
+      t = _mm256_add_epi16(_mm256_slli_epi16(t, 1), far_v);
+      candidates[CANDIDATE_HORIZONTAL] =
+          _mm256_srai_epi16(_mm256_add_epi16(t, eight), 4);
+
+      /* 2(5c + 4vt - diag - far_v) + far_h */
+      t = _mm256_add_epi16(c5, _mm256_slli_epi16(vt, 2));
+      t = _mm256_sub_epi16(_mm256_sub_epi16(t, diag), far_v);
+      t = _mm256_add_epi16(_mm256_slli_epi16(t, 1), far_h);
+      candidates[CANDIDATE_VERTICAL] =
+          _mm256_srai_epi16(_mm256_add_epi16(t, eight), 4);
+
+      /* 4(3c + diag) - 3far */
+      t = _mm256_add_epi16(_mm256_add_epi16(_mm256_slli_epi16(c, 1), c), diag);
+      t = _mm256_sub_epi16(
+          _mm256_slli_epi16(t, 2),
+          _mm256_add_epi16(_mm256_slli_epi16(far, 1), far));
+      candidates[CANDIDATE_DIAGONAL] =
+          _mm256_srai_epi16(_mm256_add_epi16(t, eight), 4);
+    }
+
+    __m256i channels[3];
+    for (guint i = 0; i < 3; i++) {
+      __m256i v = _mm256_blendv_epi8(candidates[even[i]], candidates[odd[i]],
+                                     odd_mask);
+      channels[i] = _mm256_min_epi16(_mm256_max_epi16(v, zero), max);
+    }
+
+    if (GST_PYLON_DEBAYER_OUTPUT_GRAY8 == output) {
+      __m256i y = _mm256_add_epi16(
+          _mm256_add_epi16(
+              _mm256_mullo_epi16(channels[0], _mm256_set1_epi16(77)),
+              _mm256_mullo_epi16(channels[1], _mm256_set1_epi16(150))),
+          _mm256_add_epi16(
+              _mm256_mullo_epi16(channels[2], _mm256_set1_epi16(29)),
+              _mm256_set1_epi16(128)));
+      _mm_storeu_si128((__m128i *)(dst + x),
+                       gst_pylon_debayer_narrow_avx2(_mm256_srli_epi16(y, 8)));
+      continue;
+    }
+
+    __m128i r = gst_pylon_debayer_narrow_avx2(channels[0]);
+    __m128i g = gst_pylon_debayer_narrow_avx2(channels[1]);
+    __m128i b = gst_pylon_debayer_narrow_avx2(channels[2]);
+
+    /* Build 4 byte pixels, RGB drops the padding byte afterwards */
+    __m128i first = GST_PYLON_DEBAYER_OUTPUT_BGRX == output ? b : r;
+    __m128i third = GST_PYLON_DEBAYER_OUTPUT_BGRX == output ? r : b;
+    __m128i lo = _mm_unpacklo_epi8(first, g);
+    __m128i hi = _mm_unpackhi_epi8(first, g);
+    __m128i pad_lo = _mm_unpacklo_epi8(third, opaque);
+    __m128i pad_hi = _mm_unpackhi_epi8(third, opaque);
+    __m128i quads[4] = {
+        _mm_unpacklo_epi16(lo, pad_lo), _mm_unpackhi_epi16(lo, pad_lo),
+        _mm_unpacklo_epi16(hi, pad_hi), _mm_unpackhi_epi16(hi, pad_hi)};
+
+    if (GST_PYLON_DEBAYER_OUTPUT_BGRX == output) {
+      for (guint i = 0; i < 4; i++) {
+        _mm_storeu_si128((__m128i *)(dst + 4 * x + 16 * i), quads[i]);
+      }
+    } else {
+      for (guint i = 0; i < 4; i++) {
+        _mm_storeu_si128((__m128i *)(dst + 3 * x + 12 * i),
+                         _mm_shuffle_epi8(quads[i], rgb_shuffle));
+      }
+    }
+  }
+
+  return x;
+}
+#endif
+
+#ifdef GST_PYLON_SIMD_NEON
+static inline int16x8_t gst_pylon_debayer_load_neon(const guint8 *src) {
+  return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(src)));
+}
+
+/* Same approach as the AVX2 kernel, 8 pixels at a time. The structure
+ * stores interleave the channels without writing past the block. */
+static guint gst_pylon_debayer_row_neon(const guint8 *const rows[5],
+                                        guint8 *dst, guint x, guint end,
+                                        const guint8 *even, const guint8 *odd,
+                                        GstPylonDebayerMethod method,
+                                        GstPylonDebayerOutput output) {
+  static const guint16 odd_words[8] = {0, 0xffff, 0, 0xffff,
+                                       0, 0xffff, 0, 0xffff};
+  const uint16x8_t odd_mask = vld1q_u16(odd_words);
+  const int16x8_t zero = vdupq_n_s16(0);
+  const int16x8_t max = vdupq_n_s16(255);
+  const int16x8_t one = vdupq_n_s16(1);
+  const int16x8_t two = vdupq_n_s16(2);
+  const int16x8_t eight = vdupq_n_s16(8);
+
+  for (; x + 8 <= end; x += 8) {
+    const guint8 *up = rows[1] + x;
+    const guint8 *mid = rows[2] + x;
+    const guint8 *down = rows[3] + x;
+    int16x8_t candidates[N_CANDIDATES];
+
+    int16x8_t c = gst_pylon_debayer_load_neon(mid);
+    int16x8_t hz = vaddq_s16(gst_pylon_debayer_load_neon(mid - 1),
+                             gst_pylon_debayer_load_neon(mid + 1));
+    int16x8_t vt = vaddq_s16(gst_pylon_debayer_load_neon(up),
+                             gst_pylon_debayer_load_neon(down));
+    int16x8_t diag =
+        vaddq_s16(vaddq_s16(gst_pylon_debayer_load_neon(up - 1),
+                            gst_pylon_debayer_load_neon(up + 1)),
+                  vaddq_s16(gst_pylon_debayer_load_neon(down - 1),
+                            gst_pylon_debayer_load_neon(down + 1)));
+
+    candidates[CANDIDATE_CENTER] = c;
+
+    if (GST_PYLON_DEBAYER_BILINEAR == method) {
+      candidates[CANDIDATE_GREEN] =
+          vshrq_n_s16(vaddq_s16(vaddq_s16(hz, vt), two), 2);
+      candidates[CANDIDATE_HORIZONTAL] = vshrq_n_s16(vaddq_s16(hz, one), 1);
+      candidates[CANDIDATE_VERTICAL] = vshrq_n_s16(vaddq_s16(vt, one), 1);
+      candidates[CANDIDATE_DIAGONAL] = vshrq_n_s16(vaddq_s16(diag, two), 2);
+    } else {
+      int16x8_t far_h = vaddq_s16(gst_pylon_debayer_load_neon(mid - 2),
+                                  gst_pylon_debayer_load_neon(mid + 2));
+      int16x8_t far_v = vaddq_s16(gst_pylon_debayer_load_neon(rows[0] + x),
+                                  gst_pylon_debayer_load_neon(rows[4] + x));
+      int16x8_t far = vaddq_s16(far_h, far_v);
+      int16x8_t c5 = vaddq_s16(vshlq_n_s16(c, 2), c);
+      int16x8_t t;
+
+      t = vshlq_n_s16(vaddq_s16(vshlq_n_s16(c, 1), vaddq_s16(hz, vt)), 2);
+      t = vsubq_s16(t, vshlq_n_s16(far, 1));
+      candidates[CANDIDATE_GREEN] = vshrq_n_s16(vaddq_s16(t, eight), 4);
+
+      t = vsubq_s16(vsubq_s16(vaddq_s16(c5, vshlq_n_s16(hz, 2)), diag), far_h);
+      t = vaddq_s16(vshlq_n_s16(t, 1), far_v);
+      candidates[CANDIDATE_HORIZONTAL] = vshrq_n_s16(vaddq_s16(t, eight), 4);
+
+      t = vsubq_s16(vsubq_s16(vaddq_s16(c5, vshlq_n_s16(vt, 2)), diag), far_v);
+      t = vaddq_s16(vshlq_n_s16(t, 1), far_h);
+      candidates[CANDIDATE_VERTICAL] = vshrq_n_s16(vaddq_s16(t, eight), 4);
+
+      t = vaddq_s16(vaddq_s16(vshlq_n_s16(c, 1), c), diag);
+      t = vsubq_s16(vshlq_n_s16(t, 2), vaddq_s16(vshlq_n_s16(far, 1), far));
+      candidates[CANDIDATE_DIAGONAL] = vshrq_n_s16(vaddq_s16(t, eight), 4);
+    }
+
+    uint8x8_t channels[3];
+    uint16x8_t wide[3];
+    for (guint i = 0; i < 3; i++) {
+      int16x8_t v =
+          vbslq_s16(odd_mask, candidates[odd[i]], candidates[even[i]]);
+      wide[i] = vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(v, zero), max));
+      channels[i] = vmovn_u16(wide[i]);
+    }
+
+    switch (output) {
+      case GST_PYLON_DEBAYER_OUTPUT_RGB: {
+        uint8x8x3_t rgb = {{channels[0], channels[1], channels[2]}};
+        vst3_u8(dst + 3 * x, rgb);
+        break;
+      }
+      case GST_PYLON_DEBAYER_OUTPUT_BGRX: {
+        uint8x8x4_t bgrx = {
+            {channels[2], channels[1], channels[0], vdup_n_u8(0xff)}};
+        vst4_u8(dst + 4 * x, bgrx);
+        break;
+      }
+      case GST_PYLON_DEBAYER_OUTPUT_GRAY8: {
+        uint16x8_t y = vmulq_n_u16(wide[0], 77);
+        y = vmlaq_n_u16(y, wide[1], 150);
+        y = vmlaq_n_u16(y, wide[2], 29);
+        y = vaddq_u16(y, vdupq_n_u16(128));
+        vst1_u8(dst + x, vshrn_n_u16(y, 8));
+        break;
+      }
+    }
+  }
+
+  return x;
+}
+#endif
+
+static void gst_pylon_debayer_row(const guint8 *src, gsize src_stride,
+                                  guint width, guint height, guint y,
+                                  guint8 *dst, GstPylonDebayerPattern pattern,
+                                  GstPylonDebayerMethod method,
+                                  GstPylonDebayerOutput output) {
+  const GstPylonDebayerKind *kinds = pattern_kinds[pattern][y % 2];
+  const guint8 *even = kind_candidates[kinds[0]];
+  const guint8 *odd = kind_candidates[kinds[1]];
+  gint candidates[N_CANDIDATES];
+  guint x = 0;
+
+  /* The vector kernels only see rows and columns with the whole
+   * neighborhood inside the image, the borders are mirrored by the scalar
+   * path */
+  if (y >= BORDER && y + BORDER < height && width > 2 * BORDER) {
+    const guint8 *rows[5];
+    guint end = width - BORDER;
+
+    for (guint i = 0; i < 5; i++) {
+      rows[i] = src + (y + i - BORDER) * src_stride;
+    }
+
+    for (; x < BORDER; x++) {
+      gst_pylon_debayer_pixel(src, src_stride, width, height, x, y, method,
+                              candidates);
+      const guint8 *sources = x % 2 ? odd : even;
+      gst_pylon_debayer_store(output, dst, x, candidates[sources[0]],
+                              candidates[sources[1]], candidates[sources[2]]);
+    }
+
+#ifdef GST_PYLON_SIMD_AVX2
+    if (gst_pylon_simd_have_avx2()) {
+      x = gst_pylon_debayer_row_avx2(rows, dst, x, end, even, odd, method,
+                                     output);
+    }
+#endif
+#ifdef GST_PYLON_SIMD_NEON
+    x = gst_pylon_debayer_row_neon(rows, dst, x, end, even, odd, method,
+                                   output);
+#endif
+  }
+
+  for (; x < width; x++) {
+    gst_pylon_debayer_pixel(src, src_stride, width, height, x, y, method,
+                            candidates);
+    const guint8 *sources = x % 2 ? odd : even;
+    gst_pylon_debayer_store(output, dst, x, candidates[sources[0]],
+                            candidates[sources[1]], candidates[sources[2]]);
+  }
+}
+
+GstPylonDebayer::GstPylonDebayer()
+    : pattern(GST_PYLON_DEBAYER_PATTERN_RGGB),
+      method(GST_PYLON_DEBAYER_BILINEAR),
+      output(GST_PYLON_DEBAYER_OUTPUT_RGB),
+      src(NULL),
+      src_stride(0),
+      dst(NULL),
+      dst_stride(0),
+      width(0),
+      height(0),
+      band_height(0),
+      generation(0),
+      pending_bands(0),
+      quit(false) {}
+
+GstPylonDebayer::~GstPylonDebayer() { StopWorkers(); }
+
+bool GstPylonDebayer::GetPattern(const gchar *pfnc_name,
+                                 GstPylonDebayerPattern *pattern) {
+  g_return_val_if_fail(pfnc_name, false);
+  g_return_val_if_fail(pattern, false);
+
+  for (const auto &info : debayer_patterns) {
+    if (0 == strcmp(info.pfnc_name, pfnc_name)) {
+      *pattern = info.pattern;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool GstPylonDebayer::GetOutput(const gchar *gst_format,
+                                GstPylonDebayerOutput *output) {
+  g_return_val_if_fail(gst_format, false);
+  g_return_val_if_fail(output, false);
+
+  for (const auto &info : debayer_outputs) {
+    if (0 == strcmp(info.gst_format, gst_format)) {
+      *output = info.output;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+guint GstPylonDebayer::GetPixelStride() const {
+  for (const auto &info : debayer_outputs) {
+    if (info.output == output) {
+      return info.pixel_stride;
+    }
+  }
+
+  return 0;
+}
+
+void GstPylonDebayer::SetFormat(GstPylonDebayerPattern pattern,
+                                GstPylonDebayerMethod method,
+                                GstPylonDebayerOutput output) {
+  this->pattern = pattern;
+  this->method = method;
+  this->output = output;
+}
+
+bool GstPylonDebayer::Process(const guint8 *src, gsize src_size,
+                              gsize src_stride, guint8 *dst, gsize dst_stride,
+                              guint width, guint height) {
+  g_return_val_if_fail(src, false);
+  g_return_val_if_fail(dst, false);
+
+  if (0 == width || 0 == height) {
+    return true;
+  }
+
+  src_stride = MAX(src_stride, width);
+  if (src_size < src_stride * (height - 1) + width) {
+    return false;
+  }
+
+  this->src = src;
+  this->src_stride = src_stride;
+  this->dst = dst;
+  this->dst_stride = dst_stride;
+  this->width = width;
+  this->height = height;
+
+  guint n_bands = CLAMP(height / MIN_BAND_HEIGHT, 1, MAX_DEBAYER_BANDS);
+  if (n_bands > 1) {
+    StartWorkers();
+    n_bands = MIN(n_bands, workers.size() + 1);
+  }
+  band_height = (height + n_bands - 1) / n_bands;
+
+  if (1 == n_bands) {
+    ProcessBand(0);
+    return true;
+  }
+
+  /* Every worker is woken, the ones past the last band have nothing to do */
+  {
+    std::lock_guard<std::mutex> lock(band_mutex);
+    generation++;
+    pending_bands = workers.size();
+  }
+  start_cv.notify_all();
+
+  ProcessBand(0);
+
+  std::unique_lock<std::mutex> lock(band_mutex);
+  done_cv.wait(lock, [this] { return 0 == pending_bands; });
+
+  return true;
+}
+
+void GstPylonDebayer::StartWorkers() {
+  if (!workers.empty()) {
+    return;
+  }
+
+  guint n_threads = MIN(std::thread::hardware_concurrency(), MAX_DEBAYER_BANDS);
+
+  /* Band 0 is converted by the calling thread */
+  for (guint band = 1; band < n_threads; band++) {
+    workers.emplace_back(&GstPylonDebayer::RunWorker, this, band, generation);
+  }
+}
+
+void GstPylonDebayer::StopWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(band_mutex);
+    quit = true;
+  }
+  start_cv.notify_all();
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+}
+
+void GstPylonDebayer::RunWorker(guint band, uint64_t seen) {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(band_mutex);
+      start_cv.wait(lock, [&] { return quit || generation != seen; });
+      if (quit) {
+        return;
+      }
+      seen = generation;
+    }
+
+    ProcessBand(band);
+
+    std::lock_guard<std::mutex> lock(band_mutex);
+    if (0 == --pending_bands) {
+      done_cv.notify_one();
+    }
+  }
+}
+
+void GstPylonDebayer::ProcessBand(guint band) {
+  guint first = band * band_height;
+  guint last = MIN(first + band_height, height);
+
+  for (guint y = first; y < last; y++) {
+    gst_pylon_debayer_row(src, src_stride, width, height, y,
+                          dst + y * dst_stride, pattern, method, output);
+  }
+}
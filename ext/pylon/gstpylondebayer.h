@@ -0,0 +1,113 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GST_PYLON_DEBAYER_H_
+#define _GST_PYLON_DEBAYER_H_
+
+#include <gst/gst.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Color of the top left pixel of the 2x2 Bayer tile */
+typedef enum {
+  GST_PYLON_DEBAYER_PATTERN_RGGB = 0,
+  GST_PYLON_DEBAYER_PATTERN_BGGR = 1,
+  GST_PYLON_DEBAYER_PATTERN_GRBG = 2,
+  GST_PYLON_DEBAYER_PATTERN_GBRG = 3,
+} GstPylonDebayerPattern;
+
+typedef enum {
+  /* Average of the nearest samples of each color */
+  GST_PYLON_DEBAYER_BILINEAR = 0,
+  /* Malvar-He-Cutler gradient corrected interpolation over a 5x5
+   * neighborhood, sharper edges with less color fringing */
+  GST_PYLON_DEBAYER_HIGH_QUALITY = 1,
+} GstPylonDebayerMethod;
+
+typedef enum {
+  GST_PYLON_DEBAYER_OUTPUT_RGB = 0,
+  GST_PYLON_DEBAYER_OUTPUT_BGRX = 1,
+  GST_PYLON_DEBAYER_OUTPUT_GRAY8 = 2,
+} GstPylonDebayerOutput;
+
+/* Converts 8 bit Bayer images to RGB, BGRx or GRAY8. Each image is split in
+ * bands of rows that are converted in parallel, one by the calling thread
+ * and one by each worker of a pool started on first use. The rows are
+ * converted with AVX2 or NEON where available. */
+class GstPylonDebayer {
+ public:
+  GstPylonDebayer();
+  ~GstPylonDebayer();
+  static bool GetPattern(const gchar *pfnc_name,
+                         GstPylonDebayerPattern *pattern);
+  static bool GetOutput(const gchar *gst_format,
+                        GstPylonDebayerOutput *output);
+  void SetFormat(GstPylonDebayerPattern pattern, GstPylonDebayerMethod method,
+                 GstPylonDebayerOutput output);
+  /* Bytes per pixel of the output format */
+  guint GetPixelStride() const;
+  bool Process(const guint8 *src, gsize src_size, gsize src_stride,
+               guint8 *dst, gsize dst_stride, guint width, guint height);
+
+ private:
+  GstPylonDebayerPattern pattern;
+  GstPylonDebayerMethod method;
+  GstPylonDebayerOutput output;
+
+  /* Image being converted, only written while no band is in progress */
+  const guint8 *src;
+  gsize src_stride;
+  guint8 *dst;
+  gsize dst_stride;
+  guint width;
+  guint height;
+  guint band_height;
+
+  std::vector<std::thread> workers;
+  std::mutex band_mutex;
+  std::condition_variable start_cv;
+  std::condition_variable done_cv;
+  uint64_t generation;
+  guint pending_bands;
+  bool quit;
+
+  void StartWorkers();
+  void StopWorkers();
+  void RunWorker(guint band, uint64_t seen);
+  void ProcessBand(guint band);
+};
+
+#endif
@@ -48,5 +48,6 @@ void GstPylonDisconnectHandler::OnCameraDeviceRemoved(
   GST_ELEMENT_ERROR(this->gstpylnsrc, LIBRARY, FAILED,
                     ("Connection to camera was lost."),
                     ("The camera has been removed from the computer."));
+  this->image_handler->InterruptWaitForSpace();
   this->image_handler->InterruptWaitForImage();
 }
@@ -0,0 +1,236 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstpylonformatconverter.h"
+
+#include <cstring>
+
+/* Images converted concurrently, each worker converts a whole image */
+static constexpr guint MAX_CONVERTER_WORKERS = 4;
+
+typedef struct {
+  const gchar *gst_format;
+  Pylon::EPixelType output;
+  guint pixel_stride;
+} GstPylonConverterOutputInfo;
+
+static const GstPylonConverterOutputInfo converter_outputs[] = {
+    {"RGB", Pylon::PixelType_RGB8packed, 3},
+    {"BGRx", Pylon::PixelType_BGRA8packed, 4},
+    {"GRAY8", Pylon::PixelType_Mono8, 1}};
+
+static guint gst_pylon_format_converter_get_n_workers() {
+  return CLAMP(std::thread::hardware_concurrency(), 1, MAX_CONVERTER_WORKERS);
+}
+
+GstPylonFormatConverter::GstPylonFormatConverter()
+    : output(Pylon::PixelType_RGB8packed),
+      pixel_stride(3),
+      unclaimed_jobs(0),
+      quit(false) {}
+
+GstPylonFormatConverter::~GstPylonFormatConverter() {
+  Flush();
+  StopWorkers();
+}
+
+bool GstPylonFormatConverter::IsSupported(const gchar *pfnc_name) {
+  g_return_val_if_fail(pfnc_name, false);
+
+  Pylon::EPixelType pixel_type =
+      Pylon::CPixelTypeMapper::GetPylonPixelTypeByName(
+          Pylon::String_t(pfnc_name));
+
+  return Pylon::PixelType_Undefined != pixel_type &&
+         Pylon::CImageFormatConverter::IsSupportedInputFormat(pixel_type);
+}
+
+bool GstPylonFormatConverter::SetFormat(const gchar *gst_format) {
+  g_return_val_if_fail(gst_format, false);
+
+  for (const auto &info : converter_outputs) {
+    if (0 == strcmp(info.gst_format, gst_format)) {
+      output = info.output;
+      pixel_stride = info.pixel_stride;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+guint GstPylonFormatConverter::GetPixelStride() const { return pixel_stride; }
+
+guint GstPylonFormatConverter::GetPending() {
+  std::lock_guard<std::mutex> lock(job_mutex);
+  return jobs.size();
+}
+
+guint GstPylonFormatConverter::GetMaxPending() const {
+  return gst_pylon_format_converter_get_n_workers();
+}
+
+void GstPylonFormatConverter::Submit(
+    Pylon::CBaslerUniversalGrabResultPtr *grab_result, GstBuffer *buf,
+    gsize stride) {
+  g_return_if_fail(grab_result);
+  g_return_if_fail(buf);
+
+  StartWorkers();
+
+  {
+    std::lock_guard<std::mutex> lock(job_mutex);
+    jobs.push_back({grab_result, buf, stride, output, false, false});
+    unclaimed_jobs++;
+  }
+  start_cv.notify_one();
+}
+
+Pylon::CBaslerUniversalGrabResultPtr *GstPylonFormatConverter::WaitForResult(
+    GstBuffer **buf, bool *converted) {
+  g_return_val_if_fail(buf, NULL);
+  g_return_val_if_fail(converted, NULL);
+
+  std::unique_lock<std::mutex> lock(job_mutex);
+  if (jobs.empty()) {
+    *buf = NULL;
+    *converted = false;
+    return NULL;
+  }
+
+  done_cv.wait(lock, [this] { return jobs.front().done; });
+
+  Job &job = jobs.front();
+  Pylon::CBaslerUniversalGrabResultPtr *grab_result = job.grab_result;
+  *buf = job.buf;
+  *converted = job.converted;
+  jobs.pop_front();
+
+  return grab_result;
+}
+
+void GstPylonFormatConverter::Flush() {
+  std::unique_lock<std::mutex> lock(job_mutex);
+
+  /* Nobody is going to pick up the jobs waiting for a worker */
+  while (unclaimed_jobs > 0) {
+    Job &job = jobs.back();
+    delete job.grab_result;
+    gst_buffer_unref(job.buf);
+    jobs.pop_back();
+    unclaimed_jobs--;
+  }
+
+  while (!jobs.empty()) {
+    done_cv.wait(lock, [this] { return jobs.front().done; });
+
+    Job &job = jobs.front();
+    delete job.grab_result;
+    gst_buffer_unref(job.buf);
+    jobs.pop_front();
+  }
+}
+
+void GstPylonFormatConverter::StartWorkers() {
+  if (!workers.empty()) {
+    return;
+  }
+
+  guint n_threads = gst_pylon_format_converter_get_n_workers();
+  for (guint i = 0; i < n_threads; i++) {
+    workers.emplace_back(&GstPylonFormatConverter::RunWorker, this);
+  }
+}
+
+void GstPylonFormatConverter::StopWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(job_mutex);
+    quit = true;
+  }
+  start_cv.notify_all();
+
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+}
+
+void GstPylonFormatConverter::RunWorker() {
+  /* The converter keeps state between conversions and is not meant to be
+   * shared between threads */
+  Pylon::CImageFormatConverter converter;
+
+  while (true) {
+    Job *job = NULL;
+    {
+      std::unique_lock<std::mutex> lock(job_mutex);
+      start_cv.wait(lock, [this] { return quit || unclaimed_jobs > 0; });
+      if (quit) {
+        return;
+      }
+      job = &jobs[jobs.size() - unclaimed_jobs];
+      unclaimed_jobs--;
+    }
+
+    bool converted = false;
+    GstMapInfo info;
+    if (gst_buffer_map(job->buf, &info, GST_MAP_WRITE)) {
+      try {
+        const Pylon::CBaslerUniversalGrabResultPtr &grab_result =
+            *job->grab_result;
+        guint width = grab_result->GetWidth();
+        gsize row_size = width * Pylon::BitPerPixel(job->output) / 8;
+
+        converter.OutputPixelFormat.SetValue(job->output);
+        converter.OutputPaddingX.SetValue(job->stride - row_size);
+        converter.Convert(info.data, info.size, grab_result);
+        converted = true;
+      } catch (const Pylon::GenericException &e) {
+        GST_DEBUG("Unable to convert image: %s", e.GetDescription());
+      }
+      gst_buffer_unmap(job->buf, &info);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(job_mutex);
+      job->converted = converted;
+      job->done = true;
+    }
+    /* Only the oldest job is waited for, but it is unknown which one that
+     * is */
+    done_cv.notify_all();
+  }
+}
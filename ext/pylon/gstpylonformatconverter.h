@@ -0,0 +1,121 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GST_PYLON_FORMAT_CONVERTER_H_
+#define _GST_PYLON_FORMAT_CONVERTER_H_
+
+#include <gst/gst.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER  // MSVC
+#pragma warning(push)
+#pragma warning(disable : 4265)
+#elif __GNUC__  // GCC, CLANG, MinGW
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnon-virtual-dtor"
+#pragma GCC diagnostic ignored "-Woverloaded-virtual"
+#pragma GCC diagnostic ignored "-Wunused-variable"
+#endif
+
+#include <pylon/BaslerUniversalInstantCamera.h>
+#include <pylon/PylonIncludes.h>
+
+#ifdef _MSC_VER  // MSVC
+#pragma warning(pop)
+#elif __GNUC__  // GCC, CLANG, MinWG
+#pragma GCC diagnostic pop
+#endif
+
+/* Converts camera formats GStreamer has no equivalent for, e.g. BiColor or
+ * RGB with 10 or 12 bits per channel, to RGB, BGRx or GRAY8 with the pylon
+ * image format converter. Grab results are submitted in order and converted
+ * by a pool of workers started on first use, so the images already grabbed
+ * are converted while the previous one travels downstream. Results are
+ * collected in submission order. */
+class GstPylonFormatConverter {
+ public:
+  GstPylonFormatConverter();
+  ~GstPylonFormatConverter();
+  /* Whether pylon is able to convert the camera format */
+  static bool IsSupported(const gchar *pfnc_name);
+  bool SetFormat(const gchar *gst_format);
+  /* Bytes per pixel of the output format */
+  guint GetPixelStride() const;
+  /* Number of images submitted and not collected yet */
+  guint GetPending();
+  /* Number of images that may be converted concurrently */
+  guint GetMaxPending() const;
+  /* Takes ownership of the grab result and the buffer */
+  void Submit(Pylon::CBaslerUniversalGrabResultPtr *grab_result,
+              GstBuffer *buf, gsize stride);
+  /* Waits for the oldest submitted image. The buffer is returned even if
+   * the conversion failed, NULL if nothing was submitted. */
+  Pylon::CBaslerUniversalGrabResultPtr *WaitForResult(GstBuffer **buf,
+                                                      bool *converted);
+  /* Drops the submitted images once their conversion is done */
+  void Flush();
+
+ private:
+  struct Job {
+    Pylon::CBaslerUniversalGrabResultPtr *grab_result;
+    GstBuffer *buf;
+    gsize stride;
+    Pylon::EPixelType output;
+    bool done;
+    bool converted;
+  };
+
+  Pylon::EPixelType output;
+  guint pixel_stride;
+
+  /* Jobs in submission order, the last unclaimed_jobs ones are waiting for
+   * a worker. Deque elements don't move as jobs are added or removed at the
+   * ends, so workers hold on to them without the lock. */
+  std::deque<Job> jobs;
+  size_t unclaimed_jobs;
+  std::vector<std::thread> workers;
+  std::mutex job_mutex;
+  std::condition_variable start_cv;
+  std::condition_variable done_cv;
+  bool quit;
+
+  void StartWorkers();
+  void StopWorkers();
+  void RunWorker();
+};
+
+#endif
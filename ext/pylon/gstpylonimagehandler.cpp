@@ -32,39 +32,147 @@
 
 #include "gstpylonimagehandler.h"
 
+static constexpr size_t DEFAULT_QUEUE_DEPTH = 1;
+
 GstPylonImageHandler::GstPylonImageHandler()
-    : ptr_grab_result(NULL), grab_result_ready(false) {}
+    : ring(DEFAULT_QUEUE_DEPTH, NULL),
+      head(0),
+      tail(0),
+      dropped_images(0),
+      interrupted(false),
+      consumer_waiting(false),
+      producer_waiting(false),
+      space_interrupted(false),
+      block_when_full(false) {}
 
-void GstPylonImageHandler::OnImageGrabbed(
-    Pylon::CBaslerUniversalInstantCamera &camera,
-    const Pylon::CBaslerUniversalGrabResultPtr &grab_result) {
+GstPylonImageHandler::~GstPylonImageHandler() { this->FlushImages(); }
+
+bool GstPylonImageHandler::IsImageAvailable() const {
+  return this->head.load() != this->tail.load(std::memory_order_relaxed);
+}
+
+bool GstPylonImageHandler::IsSpaceAvailable() const {
+  return this->head.load(std::memory_order_relaxed) - this->tail.load() <
+         this->ring.size();
+}
+
+void GstPylonImageHandler::WakeConsumer() {
+  /* Taking the mutex guarantees the consumer is either not yet checking its
+   * wait predicate or already waiting on the condition variable */
   std::unique_lock<std::mutex> mutex_lock(this->grab_result_mutex);
-  /* Return if an interrupt was received */
-  if (this->grab_result_ready) {
-    return;
-  };
-  this->ptr_grab_result = new Pylon::CBaslerUniversalGrabResultPtr(grab_result);
-  this->grab_result_ready = true;
   mutex_lock.unlock();
   this->grab_result_cv.notify_one();
 }
 
-Pylon::CBaslerUniversalGrabResultPtr *GstPylonImageHandler::WaitForImage() {
+void GstPylonImageHandler::WakeProducer() {
   std::unique_lock<std::mutex> mutex_lock(this->grab_result_mutex);
-  this->grab_result_cv.wait(mutex_lock,
-                            [this] { return this->grab_result_ready; });
-  Pylon::CBaslerUniversalGrabResultPtr *grab_result = this->ptr_grab_result;
-  this->ptr_grab_result = NULL;
-  this->grab_result_ready = false;
   mutex_lock.unlock();
+  this->space_cv.notify_one();
+}
 
-  return grab_result;
+void GstPylonImageHandler::OnImageGrabbed(
+    Pylon::CBaslerUniversalInstantCamera &camera,
+    const Pylon::CBaslerUniversalGrabResultPtr &grab_result) {
+  /* Hold back the grab loop while the ring is full. Images then pile up in
+   * the pylon output queue instead of being dropped here. */
+  if (this->block_when_full && !this->IsSpaceAvailable() &&
+      !this->space_interrupted.load()) {
+    std::unique_lock<std::mutex> mutex_lock(this->grab_result_mutex);
+    this->producer_waiting.store(true);
+    this->space_cv.wait(mutex_lock, [this] {
+      return this->IsSpaceAvailable() || this->space_interrupted.load();
+    });
+    this->producer_waiting.store(false);
+  }
+
+  uint64_t head = this->head.load(std::memory_order_relaxed);
+  uint64_t tail = this->tail.load(std::memory_order_acquire);
+
+  /* Drop the image only if the consumer did not keep up and the ring is full */
+  if (head - tail >= this->ring.size()) {
+    this->dropped_images.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  this->ring[head % this->ring.size()] =
+      new Pylon::CBaslerUniversalGrabResultPtr(grab_result);
+  this->head.store(head + 1);
+
+  if (this->consumer_waiting.load()) {
+    this->WakeConsumer();
+  }
+}
+
+Pylon::CBaslerUniversalGrabResultPtr *GstPylonImageHandler::WaitForImage() {
+  if (!this->IsImageAvailable() && !this->interrupted.load()) {
+    std::unique_lock<std::mutex> mutex_lock(this->grab_result_mutex);
+    this->consumer_waiting.store(true);
+    this->grab_result_cv.wait(mutex_lock, [this] {
+      return this->IsImageAvailable() || this->interrupted.load();
+    });
+    this->consumer_waiting.store(false);
+  }
+
+  /* Return if an interrupt was received */
+  if (this->interrupted.exchange(false)) {
+    return NULL;
+  }
+
+  return this->PopImage();
 };
 
+Pylon::CBaslerUniversalGrabResultPtr *GstPylonImageHandler::PollImage() {
+  if (!this->IsImageAvailable()) {
+    return NULL;
+  }
+
+  return this->PopImage();
+}
+
+Pylon::CBaslerUniversalGrabResultPtr *GstPylonImageHandler::PopImage() {
+  uint64_t tail = this->tail.load(std::memory_order_relaxed);
+  Pylon::CBaslerUniversalGrabResultPtr *grab_result =
+      this->ring[tail % this->ring.size()];
+  this->ring[tail % this->ring.size()] = NULL;
+  this->tail.store(tail + 1);
+
+  if (this->producer_waiting.load()) {
+    this->WakeProducer();
+  }
+
+  return grab_result;
+}
+
 void GstPylonImageHandler::InterruptWaitForImage() {
-  std::unique_lock<std::mutex> mutex_lock(this->grab_result_mutex);
-  this->grab_result_ready = true;
-  mutex_lock.unlock();
+  this->interrupted.store(true);
+  this->WakeConsumer();
+}
 
-  this->grab_result_cv.notify_one();
+void GstPylonImageHandler::InterruptWaitForSpace() {
+  this->space_interrupted.store(true);
+  this->WakeProducer();
+}
+
+void GstPylonImageHandler::FlushImages() {
+  while (this->IsImageAvailable()) {
+    uint64_t tail = this->tail.load(std::memory_order_relaxed);
+    delete this->ring[tail % this->ring.size()];
+    this->ring[tail % this->ring.size()] = NULL;
+    this->tail.store(tail + 1, std::memory_order_release);
+  }
+}
+
+void GstPylonImageHandler::SetQueueDepth(size_t depth, bool block_when_full) {
+  this->FlushImages();
+
+  this->ring.assign(depth > 0 ? depth : DEFAULT_QUEUE_DEPTH, NULL);
+  this->head.store(0);
+  this->tail.store(0);
+  this->dropped_images.store(0);
+  this->block_when_full = block_when_full;
+  this->space_interrupted.store(false);
+}
+
+uint64_t GstPylonImageHandler::GetDroppedImages() const {
+  return this->dropped_images.load(std::memory_order_relaxed);
 }
@@ -33,8 +33,11 @@
 #ifndef _GST_PYLON_IMAGE_HANDLER_H_
 #define _GST_PYLON_IMAGE_HANDLER_H_
 
+#include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
+#include <vector>
 
 #ifdef _MSC_VER  // MSVC
 #pragma warning(push)
@@ -55,20 +58,48 @@
 #pragma GCC diagnostic pop
 #endif
 
+/* The image handler hands grab results from the pylon grab loop thread
+ * (producer) to the streaming thread (consumer) through a bounded single
+ * producer / single consumer ring. The ring itself is lock-free, the mutex
+ * and condition variables are only used to park the consumer while the ring
+ * is empty, or the producer while the ring is full and images must not be
+ * dropped. */
 class GstPylonImageHandler : public Pylon::CBaslerUniversalImageEventHandler {
  public:
   GstPylonImageHandler();
+  ~GstPylonImageHandler();
   void OnImageGrabbed(
       Pylon::CBaslerUniversalInstantCamera &camera,
       const Pylon::CBaslerUniversalGrabResultPtr &grab_result) override;
   Pylon::CBaslerUniversalGrabResultPtr *WaitForImage();
+  /* Returns NULL right away if no image is queued */
+  Pylon::CBaslerUniversalGrabResultPtr *PollImage();
   void InterruptWaitForImage();
+  void InterruptWaitForSpace();
+  /* Must only be called while the camera is not grabbing */
+  void SetQueueDepth(size_t depth, bool block_when_full);
+  void FlushImages();
+  uint64_t GetDroppedImages() const;
 
  private:
+  std::vector<Pylon::CBaslerUniversalGrabResultPtr *> ring;
+  std::atomic<uint64_t> head;
+  std::atomic<uint64_t> tail;
+  std::atomic<uint64_t> dropped_images;
+  std::atomic<bool> interrupted;
+  std::atomic<bool> consumer_waiting;
+  std::atomic<bool> producer_waiting;
+  std::atomic<bool> space_interrupted;
+  bool block_when_full;
   std::mutex grab_result_mutex;
   std::condition_variable grab_result_cv;
-  Pylon::CBaslerUniversalGrabResultPtr *ptr_grab_result;
-  bool grab_result_ready;
+  std::condition_variable space_cv;
+
+  bool IsImageAvailable() const;
+  bool IsSpaceAvailable() const;
+  void WakeConsumer();
+  void WakeProducer();
+  Pylon::CBaslerUniversalGrabResultPtr *PopImage();
 };
 
 #endif
@@ -56,6 +56,11 @@
 
 #include <gst/video/video.h>
 
+/* Number of latched camera timestamps used to fit the camera clock to the
+ * pipeline clock, and how often a new one is taken */
+#define TIMESTAMP_CORRELATION_SAMPLES 32
+#define TIMESTAMP_CORRELATION_INTERVAL GST_SECOND
+
 struct _GstPylonSrc
 {
   GstPushSrc base_pylonsrc;
@@ -69,8 +74,40 @@ struct _GstPylonSrc
   gchar *user_set;
   gchar *pfs_location;
   GstPylonCaptureErrorEnum capture_error;
+  GstPylonChunkDecodingEnum chunk_decoding;
+  GstPylonTimestampModeEnum timestamp_mode;
+  guint queue_depth;
+  GstPylonGrabStrategyEnum grab_strategy;
+  guint output_queue_size;
+  guint max_num_buffer;
+  GstPylonDebayerEnum debayer;
+  gboolean convert;
   GObject *cam;
   GObject *stream;
+
+  /* Camera to pipeline clock mapping, only accessed from the streaming
+   * thread */
+  guint64 timestamp_frequency;
+  GstClockTime first_camera_time;
+  GstClockTime first_running_time;
+  GstClock *correlation_clock;
+
+  /* The camera clock is sampled from a periodic clock callback. The lock
+   * serializes it with starting and stopping the correlation. */
+  GMutex correlation_lock;
+  GstClockID correlation_id;
+  GstClockTime correlation_samples[2 * TIMESTAMP_CORRELATION_SAMPLES];
+  GstClockTime correlation_temp[2 * TIMESTAMP_CORRELATION_SAMPLES];
+  guint n_correlation_samples;
+  guint next_correlation_sample;
+
+  /* Fitted mapping, protected by the object lock */
+  gboolean correlation_valid;
+  gboolean correlation_failed;
+  GstClockTime correlation_internal;
+  GstClockTime correlation_external;
+  GstClockTime correlation_num;
+  GstClockTime correlation_denom;
 };
 
 /* prototypes */
@@ -82,8 +119,10 @@ static void gst_pylon_src_get_property (GObject * object,
     guint property_id, GValue * value, GParamSpec * pspec);
 static void gst_pylon_src_finalize (GObject * object);
 
+static gboolean gst_pylon_src_is_inspecting (void);
 static GstCaps *gst_pylon_src_get_caps (GstBaseSrc * src, GstCaps * filter);
 static gboolean gst_pylon_src_is_bayer (GstStructure * st);
+static guint gst_pylon_src_get_bayer_bpp (GstStructure * st);
 static GstCaps *gst_pylon_src_fixate (GstBaseSrc * src, GstCaps * caps);
 static gboolean gst_pylon_src_set_caps (GstBaseSrc * src, GstCaps * caps);
 static gboolean gst_pylon_src_decide_allocation (GstBaseSrc * src,
@@ -94,6 +133,15 @@ static gboolean gst_pylon_src_unlock (GstBaseSrc * src);
 static gboolean gst_pylon_src_query (GstBaseSrc * src, GstQuery * query);
 static void gst_plyon_src_add_metadata (GstPylonSrc * self, GstBuffer * buf);
 static GstFlowReturn gst_pylon_src_create (GstPushSrc * src, GstBuffer ** buf);
+static void gst_pylon_src_reset_timestamps (GstPylonSrc * self);
+static void gst_pylon_src_free_pylon (GstPylonSrc * self);
+static void gst_pylon_src_start_correlation (GstPylonSrc * self,
+    GstClock * clock);
+static void gst_pylon_src_stop_correlation (GstPylonSrc * self);
+static gboolean gst_pylon_src_correlate_timestamps (GstClock * clock,
+    GstClockTime time, GstClockID id, gpointer user_data);
+static GstClockTime gst_pylon_src_get_timestamp (GstPylonSrc * self,
+    GstClock * clock, GstClockTime base_time, guint64 camera_ticks);
 
 static void gst_pylon_src_child_proxy_init (GstChildProxyInterface * iface);
 
@@ -106,6 +154,15 @@ enum
   PROP_USER_SET,
   PROP_PFS_LOCATION,
   PROP_CAPTURE_ERROR,
+  PROP_CHUNK_DECODING,
+  PROP_TIMESTAMP_MODE,
+  PROP_QUEUE_DEPTH,
+  PROP_DROPPED_IMAGES,
+  PROP_GRAB_STRATEGY,
+  PROP_OUTPUT_QUEUE_SIZE,
+  PROP_MAX_NUM_BUFFER,
+  PROP_DEBAYER,
+  PROP_CONVERT,
   PROP_CAM,
   PROP_STREAM
 };
@@ -120,10 +177,37 @@ enum
 #define PROP_CAM_DEFAULT NULL
 #define PROP_STREAM_DEFAULT NULL
 #define PROP_CAPTURE_ERROR_DEFAULT ENUM_ABORT
+#define PROP_CHUNK_DECODING_DEFAULT ENUM_CHUNKS_EAGER
+#define PROP_TIMESTAMP_MODE_DEFAULT ENUM_TIMESTAMP_PIPELINE_CLOCK
+#define PROP_QUEUE_DEPTH_DEFAULT 1
+#define PROP_QUEUE_DEPTH_MIN 1
+#define PROP_QUEUE_DEPTH_MAX 1024
+#define PROP_DROPPED_IMAGES_DEFAULT 0
+#define PROP_GRAB_STRATEGY_DEFAULT ENUM_LATEST_IMAGE_ONLY
+#define PROP_OUTPUT_QUEUE_SIZE_DEFAULT 1
+#define PROP_OUTPUT_QUEUE_SIZE_MIN 1
+#define PROP_OUTPUT_QUEUE_SIZE_MAX 1024
+#define PROP_MAX_NUM_BUFFER_DEFAULT 0
+#define PROP_MAX_NUM_BUFFER_MIN 0
+#define PROP_MAX_NUM_BUFFER_MAX 1024
+#define PROP_DEBAYER_DEFAULT ENUM_DEBAYER_OFF
+#define PROP_CONVERT_DEFAULT FALSE
 
 /* Enum for cature_error */
 #define GST_TYPE_CAPTURE_ERROR_ENUM (gst_pylon_capture_error_enum_get_type ())
 
+/* Enum for timestamp_mode */
+#define GST_TYPE_TIMESTAMP_MODE_ENUM (gst_pylon_timestamp_mode_enum_get_type ())
+
+/* Enum for chunk_decoding */
+#define GST_TYPE_CHUNK_DECODING_ENUM (gst_pylon_chunk_decoding_enum_get_type ())
+
+/* Enum for grab_strategy */
+#define GST_TYPE_GRAB_STRATEGY_ENUM (gst_pylon_grab_strategy_enum_get_type ())
+
+/* Enum for debayer */
+#define GST_TYPE_DEBAYER_ENUM (gst_pylon_debayer_enum_get_type ())
+
 /* Child proxy interface names */
 static const gchar *gst_pylon_src_child_proxy_names[] = {
   "cam",
@@ -150,16 +234,119 @@ gst_pylon_capture_error_enum_get_type (void)
   return (GType) gtype;
 }
 
+static GType
+gst_pylon_timestamp_mode_enum_get_type (void)
+{
+  static gsize gtype = 0;
+  static const GEnumValue values[] = {
+    {ENUM_TIMESTAMP_PIPELINE_CLOCK, "pipeline-clock",
+        "Timestamp buffers with the pipeline clock when they are pushed"},
+    {ENUM_TIMESTAMP_CAMERA, "camera",
+        "Timestamp buffers with the camera time elapsed since the first image"},
+    {ENUM_TIMESTAMP_CAMERA_CORRELATED, "camera-correlated",
+        "Timestamp buffers with the camera time mapped to the pipeline clock"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&gtype)) {
+    GType tmp = g_enum_register_static ("GstPylonTimestampModeEnum", values);
+    g_once_init_leave (&gtype, tmp);
+  }
+
+  return (GType) gtype;
+}
+
+static GType
+gst_pylon_chunk_decoding_enum_get_type (void)
+{
+  static gsize gtype = 0;
+  static const GEnumValue values[] = {
+    {ENUM_CHUNKS_EAGER, "eager",
+        "Decode chunks in the streaming thread for every image"},
+    {ENUM_CHUNKS_LAZY, "lazy",
+        "Decode chunks the first time a consumer reads them"},
+    {ENUM_CHUNKS_OFF, "off", "Do not decode chunks"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&gtype)) {
+    GType tmp = g_enum_register_static ("GstPylonChunkDecodingEnum", values);
+    g_once_init_leave (&gtype, tmp);
+  }
+
+  return (GType) gtype;
+}
+
+static GType
+gst_pylon_grab_strategy_enum_get_type (void)
+{
+  static gsize gtype = 0;
+  static const GEnumValue values[] = {
+    {ENUM_ONE_BY_ONE, "one-by-one",
+        "Deliver every grabbed image in the order it arrived. When the "
+          "pipeline does not keep up, images wait in the pylon buffers and "
+          "frames arriving once all of them are filled are dropped by the "
+          "transport layer."},
+    {ENUM_LATEST_IMAGE_ONLY, "latest-image-only",
+        "Deliver only the most recent grabbed image"},
+    {ENUM_LATEST_IMAGES, "latest-images",
+        "Deliver the most recent grabbed images, up to output-queue-size"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&gtype)) {
+    GType tmp = g_enum_register_static ("GstPylonGrabStrategyEnum", values);
+    g_once_init_leave (&gtype, tmp);
+  }
+
+  return (GType) gtype;
+}
+
+static GType
+gst_pylon_debayer_enum_get_type (void)
+{
+  static gsize gtype = 0;
+  static const GEnumValue values[] = {
+    {ENUM_DEBAYER_OFF, "off", "Only offer the formats delivered by the camera"},
+    {ENUM_DEBAYER_BILINEAR, "bilinear",
+        "Debayer with bilinear interpolation"},
+    {ENUM_DEBAYER_HIGH_QUALITY, "high-quality",
+        "Debayer with gradient corrected interpolation, slower but with "
+          "sharper edges and less color fringing"},
+    {0, NULL, NULL}
+  };
+
+  if (g_once_init_enter (&gtype)) {
+    GType tmp = g_enum_register_static ("GstPylonDebayerEnum", values);
+    g_once_init_leave (&gtype, tmp);
+  }
+
+  return (GType) gtype;
+}
+
 /* pad templates */
 
 static GstStaticPadTemplate gst_pylon_src_src_template =
     GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (" {GRAY8, RGB, BGR, YUY2, UYVY} ") ";"
-        "video/x-bayer,format={rggb,bggr,gbgr,grgb},width=" GST_VIDEO_SIZE_RANGE
-        ",height=" GST_VIDEO_SIZE_RANGE ",framerate=" GST_VIDEO_FPS_RANGE));
+    GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (" {GRAY8, GRAY16_LE, RGB, BGR, BGRx, YUY2, UYVY} ") ";"
+        "video/x-bayer,format={rggb,bggr,gbrg,grbg,rggb10le,bggr10le,gbrg10le,"
+        "grbg10le,rggb12le,bggr12le,gbrg12le,grbg12le,rggb16le,bggr16le,"
+        "gbrg16le,grbg16le},width=" GST_VIDEO_SIZE_RANGE
+        ",height=" GST_VIDEO_SIZE_RANGE ",framerate=" GST_VIDEO_FPS_RANGE ";"
+        "video/x-pylon-packed,format={Mono10p,Mono12p,Mono12Packed},width="
+        GST_VIDEO_SIZE_RANGE ",height=" GST_VIDEO_SIZE_RANGE ",framerate="
+        GST_VIDEO_FPS_RANGE));
+
+
+static gboolean
+gst_pylon_src_is_inspecting (void)
+{
+  const gchar *prgname = g_get_prgname ();
 
+  return prgname && g_str_has_prefix (prgname, "gst-inspect");
+}
 
 /* class initialization */
 G_DEFINE_TYPE_WITH_CODE (GstPylonSrc, gst_pylon_src, GST_TYPE_PUSH_SRC,
@@ -240,19 +427,105 @@ gst_pylon_src_class_init (GstPylonSrcClass * klass)
           "The strategy to use in case of a camera capture error.",
           GST_TYPE_CAPTURE_ERROR_ENUM, PROP_CAPTURE_ERROR_DEFAULT,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
+  g_object_class_install_property (gobject_class, PROP_CHUNK_DECODING,
+      g_param_spec_enum ("chunk-decoding",
+          "Chunk decoding",
+          "When to decode the chunks attached to the pylon meta.",
+          GST_TYPE_CHUNK_DECODING_ENUM, PROP_CHUNK_DECODING_DEFAULT,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE));
+  g_object_class_install_property (gobject_class, PROP_TIMESTAMP_MODE,
+      g_param_spec_enum ("timestamp-mode",
+          "Timestamp mode",
+          "The time base used for the buffer timestamps. The camera modes "
+          "use the time the image was captured by the camera instead of the "
+          "time it reached the pipeline. Changes take effect the next time "
+          "the element starts.",
+          GST_TYPE_TIMESTAMP_MODE_ENUM, PROP_TIMESTAMP_MODE_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_QUEUE_DEPTH,
+      g_param_spec_uint ("queue-depth", "Image queue depth",
+          "The number of grabbed images that can be queued between the "
+          "camera and the pipeline. Images are only dropped once the queue "
+          "is full. Changes take effect the next time the camera starts "
+          "grabbing.", PROP_QUEUE_DEPTH_MIN, PROP_QUEUE_DEPTH_MAX,
+          PROP_QUEUE_DEPTH_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_DROPPED_IMAGES,
+      g_param_spec_uint64 ("dropped-images", "Dropped images",
+          "The number of grabbed images dropped because the image queue "
+          "was full since the camera started grabbing.", 0, G_MAXUINT64,
+          PROP_DROPPED_IMAGES_DEFAULT,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_GRAB_STRATEGY,
+      g_param_spec_enum ("grab-strategy", "Grab strategy",
+          "The pylon grab strategy used to hand images from the camera to "
+          "the pipeline. Changes take effect the next time the camera "
+          "starts grabbing.",
+          GST_TYPE_GRAB_STRATEGY_ENUM, PROP_GRAB_STRATEGY_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_OUTPUT_QUEUE_SIZE,
+      g_param_spec_uint ("output-queue-size", "Output queue size",
+          "The number of most recent images kept by pylon when using the "
+          "latest-images grab strategy. Must not exceed the number of "
+          "buffers allocated by pylon.", PROP_OUTPUT_QUEUE_SIZE_MIN,
+          PROP_OUTPUT_QUEUE_SIZE_MAX, PROP_OUTPUT_QUEUE_SIZE_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_MAX_NUM_BUFFER,
+      g_param_spec_uint ("max-num-buffer", "Maximum number of pylon buffers",
+          "The number of grab buffers allocated by pylon. Buffers stay in "
+          "use while their images are queued or held downstream, so this "
+          "should cover the queue depth plus the buffers kept by the "
+          "pipeline. 0 keeps the pylon default.", PROP_MAX_NUM_BUFFER_MIN,
+          PROP_MAX_NUM_BUFFER_MAX, PROP_MAX_NUM_BUFFER_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_DEBAYER,
+      g_param_spec_enum ("debayer", "Debayer",
+          "Also offer RGB, BGRx and GRAY8 for cameras delivering 8 bit Bayer "
+          "formats, converted in the element by several threads. Formats "
+          "the camera delivers itself are preferred. Changes take effect "
+          "the next time caps are negotiated.",
+          GST_TYPE_DEBAYER_ENUM, PROP_DEBAYER_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_CONVERT,
+      g_param_spec_boolean ("convert", "Convert",
+          "Also offer RGB, BGRx and GRAY8 for camera formats GStreamer has "
+          "no equivalent for, e.g. BiColor, YCbCr411 or RGB with 10 or 12 "
+          "bits per channel. Images are converted by pylon on several "
+          "threads while the previous ones are pushed downstream. Changes "
+          "take effect the next time caps are negotiated.",
+          PROP_CONVERT_DEFAULT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
 
-  cam_params = gst_pylon_camera_get_string_properties ();
-  stream_params = gst_pylon_stream_grabber_get_string_properties ();
-
-  if (NULL == cam_params) {
-    cam_prolog = "No valid cameras where found connected to the system.";
-    stream_prolog = cam_prolog;
+  /* Listing the properties of every device requires opening all of them,
+   * only do so when the element is being inspected */
+  if (!gst_pylon_src_is_inspecting ()) {
+    cam_prolog = "Inspect the element to list the properties of each camera.";
+    stream_prolog =
+        "Inspect the element to list the properties of each stream grabber.";
     cam_params = g_strdup ("");
     stream_params = g_strdup ("");
   } else {
-    cam_prolog = "The following list details the properties for each camera.\n";
-    stream_prolog =
-        "The following list details the properties for each stream grabber.\n";
+    gst_pylon_get_string_properties (&cam_params, &stream_params);
+
+    if (NULL == cam_params) {
+      cam_prolog = "No valid cameras where found connected to the system.";
+      stream_prolog = cam_prolog;
+      cam_params = g_strdup ("");
+      stream_params = g_strdup ("");
+    } else {
+      cam_prolog =
+          "The following list details the properties for each camera.\n";
+      stream_prolog =
+          "The following list details the properties for each stream "
+          "grabber.\n";
+    }
   }
 
   cam_blurb = g_strdup_printf ("The camera to use.\n"
@@ -305,8 +578,19 @@ gst_pylon_src_init (GstPylonSrc * self)
   self->user_set = PROP_USER_SET_DEFAULT;
   self->pfs_location = PROP_PFS_LOCATION_DEFAULT;
   self->capture_error = PROP_CAPTURE_ERROR_DEFAULT;
+  self->chunk_decoding = PROP_CHUNK_DECODING_DEFAULT;
+  self->timestamp_mode = PROP_TIMESTAMP_MODE_DEFAULT;
+  self->queue_depth = PROP_QUEUE_DEPTH_DEFAULT;
+  self->grab_strategy = PROP_GRAB_STRATEGY_DEFAULT;
+  self->output_queue_size = PROP_OUTPUT_QUEUE_SIZE_DEFAULT;
+  self->max_num_buffer = PROP_MAX_NUM_BUFFER_DEFAULT;
+  self->debayer = PROP_DEBAYER_DEFAULT;
+  self->convert = PROP_CONVERT_DEFAULT;
   self->cam = PROP_CAM_DEFAULT;
   self->stream = PROP_STREAM_DEFAULT;
+  self->correlation_clock = NULL;
+  self->correlation_id = NULL;
+  g_mutex_init (&self->correlation_lock);
   gst_video_info_init (&self->video_info);
 
   gst_base_src_set_live (base, TRUE);
@@ -346,6 +630,30 @@ gst_pylon_src_set_property (GObject * object, guint property_id,
     case PROP_CAPTURE_ERROR:
       self->capture_error = g_value_get_enum (value);
       break;
+    case PROP_CHUNK_DECODING:
+      self->chunk_decoding = g_value_get_enum (value);
+      break;
+    case PROP_TIMESTAMP_MODE:
+      self->timestamp_mode = g_value_get_enum (value);
+      break;
+    case PROP_QUEUE_DEPTH:
+      self->queue_depth = g_value_get_uint (value);
+      break;
+    case PROP_GRAB_STRATEGY:
+      self->grab_strategy = g_value_get_enum (value);
+      break;
+    case PROP_OUTPUT_QUEUE_SIZE:
+      self->output_queue_size = g_value_get_uint (value);
+      break;
+    case PROP_MAX_NUM_BUFFER:
+      self->max_num_buffer = g_value_get_uint (value);
+      break;
+    case PROP_DEBAYER:
+      self->debayer = g_value_get_enum (value);
+      break;
+    case PROP_CONVERT:
+      self->convert = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -383,6 +691,35 @@ gst_pylon_src_get_property (GObject * object, guint property_id,
     case PROP_CAPTURE_ERROR:
       g_value_set_enum (value, self->capture_error);
       break;
+    case PROP_CHUNK_DECODING:
+      g_value_set_enum (value, self->chunk_decoding);
+      break;
+    case PROP_TIMESTAMP_MODE:
+      g_value_set_enum (value, self->timestamp_mode);
+      break;
+    case PROP_QUEUE_DEPTH:
+      g_value_set_uint (value, self->queue_depth);
+      break;
+    case PROP_DROPPED_IMAGES:
+      g_value_set_uint64 (value,
+          self->pylon ? gst_pylon_get_dropped_images (self->pylon) :
+          PROP_DROPPED_IMAGES_DEFAULT);
+      break;
+    case PROP_GRAB_STRATEGY:
+      g_value_set_enum (value, self->grab_strategy);
+      break;
+    case PROP_OUTPUT_QUEUE_SIZE:
+      g_value_set_uint (value, self->output_queue_size);
+      break;
+    case PROP_MAX_NUM_BUFFER:
+      g_value_set_uint (value, self->max_num_buffer);
+      break;
+    case PROP_DEBAYER:
+      g_value_set_enum (value, self->debayer);
+      break;
+    case PROP_CONVERT:
+      g_value_set_boolean (value, self->convert);
+      break;
     case PROP_CAM:
       g_value_set_object (value, self->cam);
       break;
@@ -423,6 +760,9 @@ gst_pylon_src_finalize (GObject * object)
     self->stream = NULL;
   }
 
+  gst_pylon_src_stop_correlation (self);
+  g_mutex_clear (&self->correlation_lock);
+
   G_OBJECT_CLASS (gst_pylon_src_parent_class)->finalize (object);
 }
 
@@ -433,6 +773,8 @@ gst_pylon_src_get_caps (GstBaseSrc * src, GstCaps * filter)
   GstPylonSrc *self = GST_PYLON_SRC (src);
   GstCaps *outcaps = NULL;
   GError *error = NULL;
+  GstPylonDebayerEnum debayer = PROP_DEBAYER_DEFAULT;
+  gboolean convert = PROP_CONVERT_DEFAULT;
 
   if (!self->pylon) {
     outcaps = gst_pad_get_pad_template_caps (GST_BASE_SRC_PAD (self));
@@ -442,7 +784,13 @@ gst_pylon_src_get_caps (GstBaseSrc * src, GstCaps * filter)
     goto out;
   }
 
-  outcaps = gst_pylon_query_configuration (self->pylon, &error);
+  GST_OBJECT_LOCK (self);
+  debayer = self->debayer;
+  convert = self->convert;
+  GST_OBJECT_UNLOCK (self);
+
+  outcaps = gst_pylon_query_configuration (self->pylon, debayer, convert,
+      &error);
 
   if (outcaps == NULL && error) {
     goto log_gst_error;
@@ -485,6 +833,24 @@ gst_pylon_src_is_bayer (GstStructure * st)
   return is_bayer;
 }
 
+/* Bytes per pixel of a Bayer format, high bit depth formats carry their
+ * depth and endianness in the name, e.g. rggb12le */
+static guint
+gst_pylon_src_get_bayer_bpp (GstStructure * st)
+{
+  const gchar *format = NULL;
+  guint bpp = 1;
+
+  g_return_val_if_fail (st, bpp);
+
+  format = gst_structure_get_string (st, "format");
+  if (format && (g_str_has_suffix (format, "le")
+          || g_str_has_suffix (format, "be"))) {
+    bpp = 2;
+  }
+  return bpp;
+}
+
 /* called if, in negotiation, caps need fixating */
 static GstCaps *
 gst_pylon_src_fixate (GstBaseSrc * src, GstCaps * caps)
@@ -498,6 +864,8 @@ gst_pylon_src_fixate (GstBaseSrc * src, GstCaps * caps)
   static const gint preferred_framerate_num = 30;
   static const gint preferred_framerate_den = 1;
   gint preferred_width_adjusted = 0;
+  gint max_width = 0;
+  guint alignment = 0;
 
   /* get the configured width/height after applying userset and pfs */
   gint preferred_width = width_1080p;
@@ -518,8 +886,10 @@ gst_pylon_src_fixate (GstBaseSrc * src, GstCaps * caps)
   gst_caps_unref (caps);
 
   if (gst_pylon_src_is_bayer (st) && GST_VALUE_HOLDS_INT_RANGE (width_field)) {
-    preferred_width_adjusted =
-        GST_ROUND_DOWN_4 (gst_value_get_int_range_max (width_field));
+    /* Rows have to fill whole 4 byte words */
+    alignment = 4 / gst_pylon_src_get_bayer_bpp (st);
+    max_width = gst_value_get_int_range_max (width_field);
+    preferred_width_adjusted = max_width - max_width % alignment;
   } else {
     preferred_width_adjusted = preferred_width;
   }
@@ -549,18 +919,21 @@ gst_pylon_src_set_caps (GstBaseSrc * src, GstCaps * caps)
   gint numerator = 0;
   gint denominator = 0;
   gint width = 0;
-  static const gint byte_alignment = 4;
+  static const guint byte_alignment = 4;
   gchar *error_msg = NULL;
   GError *error = NULL;
   gboolean ret = FALSE;
   const gchar *action = NULL;
+  GstPylonDebayerEnum debayer = PROP_DEBAYER_DEFAULT;
+  gboolean convert = PROP_CONVERT_DEFAULT;
 
   GST_INFO_OBJECT (self, "Setting new caps: %" GST_PTR_FORMAT, caps);
 
   st = gst_caps_get_structure (caps, 0);
   gst_structure_get_int (st, "width", &width);
 
-  if (gst_pylon_src_is_bayer (st) && 0 != width % byte_alignment) {
+  if (gst_pylon_src_is_bayer (st)
+      && 0 != width * gst_pylon_src_get_bayer_bpp (st) % byte_alignment) {
     action = "configure";
     error_msg =
         g_strdup
@@ -576,6 +949,8 @@ gst_pylon_src_set_caps (GstBaseSrc * src, GstCaps * caps)
   } else {
     self->duration = GST_CLOCK_TIME_NONE;
   }
+  debayer = self->debayer;
+  convert = self->convert;
   GST_OBJECT_UNLOCK (self);
 
   ret = gst_pylon_stop (self->pylon, &error);
@@ -584,18 +959,14 @@ gst_pylon_src_set_caps (GstBaseSrc * src, GstCaps * caps)
     goto log_error;
   }
 
-  ret = gst_pylon_set_configuration (self->pylon, caps, &error);
+  ret = gst_pylon_set_configuration (self->pylon, caps, debayer, convert,
+      &error);
   if (FALSE == ret && error) {
     action = "configure";
     goto log_error;
   }
 
-  ret = gst_pylon_start (self->pylon, &error);
-  if (FALSE == ret && error) {
-    action = "start";
-    goto log_error;
-  }
-
+  /* Grabbing is restarted once the allocation has been decided */
   ret = gst_video_info_from_caps (&self->video_info, caps);
 
   goto out;
@@ -618,10 +989,115 @@ static gboolean
 gst_pylon_src_decide_allocation (GstBaseSrc * src, GstQuery * query)
 {
   GstPylonSrc *self = GST_PYLON_SRC (src);
+  GstBufferPool *pool = NULL;
+  GstAllocator *allocator = NULL;
+  GstAllocationParams params;
+  GstStructure *config = NULL;
+  GstCaps *caps = NULL;
+  GstStructure *st = NULL;
+  GError *error = NULL;
+  gboolean ret = FALSE;
+  gboolean update = FALSE;
+  const gchar *action = NULL;
+  gint width = 0;
+  gint height = 0;
+  guint size = 0;
+  guint min = 0;
+  guint max = 0;
+  guint queue_depth = PROP_QUEUE_DEPTH_DEFAULT;
+  GstPylonGrabStrategyEnum grab_strategy = PROP_GRAB_STRATEGY_DEFAULT;
+  guint output_queue_size = PROP_OUTPUT_QUEUE_SIZE_DEFAULT;
+  guint max_num_buffer = PROP_MAX_NUM_BUFFER_DEFAULT;
 
   GST_LOG_OBJECT (self, "decide_allocation");
 
-  return TRUE;
+  GST_OBJECT_LOCK (self);
+  queue_depth = self->queue_depth;
+  grab_strategy = self->grab_strategy;
+  output_queue_size = self->output_queue_size;
+  max_num_buffer = self->max_num_buffer;
+  GST_OBJECT_UNLOCK (self);
+
+  /* The pylon buffers can't be reallocated while grabbing */
+  ret = gst_pylon_stop (self->pylon, &error);
+  if (FALSE == ret && error) {
+    action = "stop";
+    goto log_error;
+  }
+
+  gst_query_parse_allocation (query, &caps, NULL);
+
+  update = gst_query_get_n_allocation_pools (query) > 0;
+  if (update) {
+    gst_query_parse_nth_allocation_pool (query, 0, NULL, &size, &min, &max);
+  }
+  size = MAX (size, GST_VIDEO_INFO_SIZE (&self->video_info));
+
+  /* Bayer caps carry no size, high bit depth frames are unpacked into
+   * buffers from the pool */
+  st = caps ? gst_caps_get_structure (caps, 0) : NULL;
+  if (st && gst_pylon_src_is_bayer (st)) {
+    gst_structure_get_int (st, "width", &width);
+    gst_structure_get_int (st, "height", &height);
+    size = MAX (size,
+        GST_ROUND_UP_4 (width * gst_pylon_src_get_bayer_bpp (st)) * height);
+  }
+
+  /* Grab directly into memory from the allocator downstream proposed, e.g.
+     memfd or shm, so frames reach IPC sinks without a copy. Memory that
+     can't stay mapped while pylon writes into it, e.g. dmabuf, falls back
+     to system memory. */
+  gst_allocation_params_init (&params);
+  if (gst_query_get_n_allocation_params (query) > 0) {
+    gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
+  }
+
+  /* Grab buffers are held by downstream, by the image queue and by the
+   * camera while it fills them */
+  min += queue_depth + 1;
+  if (max != 0) {
+    max = MAX (min, max);
+  }
+
+  pool = gst_pylon_get_buffer_pool (self->pylon);
+
+  /* Buffers still in flight from a previous negotiation keep using the
+   * current configuration */
+  if (!gst_buffer_pool_is_active (pool)) {
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, size, min, max);
+    gst_buffer_pool_config_set_allocator (config, allocator, &params);
+    if (!gst_buffer_pool_set_config (pool, config)) {
+      GST_WARNING_OBJECT (self, "Unable to configure the pylon buffer pool");
+    }
+  }
+
+  if (update) {
+    gst_query_set_nth_allocation_pool (query, 0, pool, size, min, max);
+  } else {
+    gst_query_add_allocation_pool (query, pool, size, min, max);
+  }
+
+  if (allocator) {
+    gst_object_unref (allocator);
+  }
+
+  ret = gst_pylon_start (self->pylon, queue_depth, grab_strategy,
+      output_queue_size, max_num_buffer, &error);
+  if (FALSE == ret && error) {
+    action = "start";
+    goto log_error;
+  }
+
+  goto out;
+
+log_error:
+  GST_ELEMENT_ERROR (self, LIBRARY, FAILED,
+      ("Failed to %s camera.", action), ("%s", error->message));
+  g_error_free (error);
+
+out:
+  return ret;
 }
 
 /* start and stop processing, ideal for opening/closing the resource */
@@ -634,6 +1110,8 @@ gst_pylon_src_start (GstBaseSrc * src)
   gboolean using_pfs = FALSE;
   gboolean same_device = TRUE;
 
+  gst_pylon_src_reset_timestamps (self);
+
   GST_OBJECT_LOCK (self);
   same_device = self->pylon
       && gst_pylon_is_same_device (self->pylon, self->device_index,
@@ -646,8 +1124,7 @@ gst_pylon_src_start (GstBaseSrc * src)
 
   if (self->pylon) {
     gst_pylon_stop (self->pylon, &error);
-    gst_pylon_free (self->pylon);
-    self->pylon = NULL;
+    gst_pylon_src_free_pylon (self);
 
     if (error) {
       ret = FALSE;
@@ -714,6 +1191,8 @@ gst_pylon_src_stop (GstBaseSrc * src)
 
   GST_INFO_OBJECT (self, "Stopping camera device");
 
+  gst_pylon_src_stop_correlation (self);
+
   ret = gst_pylon_stop (self->pylon, &error);
 
   if (ret == FALSE && error) {
@@ -722,12 +1201,27 @@ gst_pylon_src_stop (GstBaseSrc * src)
     g_error_free (error);
   }
 
-  gst_pylon_free (self->pylon);
-  self->pylon = NULL;
+  gst_pylon_src_free_pylon (self);
 
   return ret;
 }
 
+static void
+gst_pylon_src_free_pylon (GstPylonSrc * self)
+{
+  GstPylon *pylon = NULL;
+
+  /* Properties read the camera counters from the application threads */
+  GST_OBJECT_LOCK (self);
+  pylon = self->pylon;
+  self->pylon = NULL;
+  GST_OBJECT_UNLOCK (self);
+
+  if (pylon) {
+    gst_pylon_free (pylon);
+  }
+}
+
 /* unlock any pending access to the resource. subclasses should unlock
  * any function ASAP. */
 static gboolean
@@ -753,6 +1247,7 @@ gst_pylon_src_query (GstBaseSrc * src, GstQuery * query)
     case GST_QUERY_LATENCY:{
       GstClockTime min_latency = GST_CLOCK_TIME_NONE;
       GstClockTime max_latency = GST_CLOCK_TIME_NONE;
+      guint max_queued = 1;
 
       if (GST_CLOCK_TIME_NONE == self->duration) {
         GST_WARNING_OBJECT (src,
@@ -760,11 +1255,14 @@ gst_pylon_src_query (GstBaseSrc * src, GstQuery * query)
         goto done;
       }
 
-      /* FIXME: we are assuming we cannot hold more than one
-         buffer. Eventually we want to have Pylon::StartGrabbing's
-         MaxNumImages extend the max_latency.
-       */
-      max_latency = min_latency = self->duration;
+      /* An image may wait in the pylon and handler queues before being
+         pushed, each queued image adds a frame duration of latency */
+      if (self->pylon) {
+        max_queued = MAX (1, gst_pylon_get_max_queued_images (self->pylon));
+      }
+
+      min_latency = self->duration;
+      max_latency = self->duration * max_queued;
 
       GST_DEBUG_OBJECT (self,
           "report latency min %" GST_TIME_FORMAT " max %" GST_TIME_FORMAT,
@@ -789,7 +1287,6 @@ static void
 gst_plyon_src_add_metadata (GstPylonSrc * self, GstBuffer * buf)
 {
   GstClock *clock = NULL;
-  GstClockTime abs_time = GST_CLOCK_TIME_NONE;
   GstClockTime base_time = GST_CLOCK_TIME_NONE;
   GstClockTime timestamp = GST_CLOCK_TIME_NONE;
   GstCaps *ref = NULL;
@@ -821,15 +1318,13 @@ gst_plyon_src_add_metadata (GstPylonSrc * self, GstBuffer * buf)
   }
   GST_OBJECT_UNLOCK (self);
 
-  /* sample pipeline clock */
+  timestamp =
+      gst_pylon_src_get_timestamp (self, clock, base_time,
+      pylon_meta->timestamp);
   if (clock) {
-    abs_time = gst_clock_get_time (clock);
     gst_object_unref (clock);
-  } else {
-    abs_time = GST_CLOCK_TIME_NONE;
   }
 
-  timestamp = abs_time - base_time;
   offset = pylon_meta->block_id;
 
   GST_BUFFER_TIMESTAMP (buf) = timestamp;
@@ -857,6 +1352,250 @@ gst_plyon_src_add_metadata (GstPylonSrc * self, GstBuffer * buf)
       height, n_planes, self->video_info.offset, stride);
 }
 
+static void
+gst_pylon_src_reset_timestamps (GstPylonSrc * self)
+{
+  gst_pylon_src_stop_correlation (self);
+
+  self->timestamp_frequency = 0;
+  self->first_camera_time = GST_CLOCK_TIME_NONE;
+  self->first_running_time = GST_CLOCK_TIME_NONE;
+}
+
+/* Sample the camera clock periodically on the clock thread, so that the
+ * device round trip of the latch doesn't delay the streaming thread */
+static void
+gst_pylon_src_start_correlation (GstPylonSrc * self, GstClock * clock)
+{
+  if (clock == self->correlation_clock) {
+    return;
+  }
+
+  gst_pylon_src_stop_correlation (self);
+
+  g_mutex_lock (&self->correlation_lock);
+
+  self->n_correlation_samples = 0;
+  self->next_correlation_sample = 0;
+
+  GST_OBJECT_LOCK (self);
+  self->correlation_valid = FALSE;
+  self->correlation_failed = FALSE;
+  GST_OBJECT_UNLOCK (self);
+
+  self->correlation_clock = gst_object_ref (clock);
+  self->correlation_id =
+      gst_clock_new_periodic_id (clock, gst_clock_get_time (clock),
+      TIMESTAMP_CORRELATION_INTERVAL);
+  gst_clock_id_wait_async (self->correlation_id,
+      gst_pylon_src_correlate_timestamps, gst_object_ref (self),
+      (GDestroyNotify) gst_object_unref);
+
+  g_mutex_unlock (&self->correlation_lock);
+}
+
+/* Waits for a sample in progress, the camera may be freed afterwards */
+static void
+gst_pylon_src_stop_correlation (GstPylonSrc * self)
+{
+  g_mutex_lock (&self->correlation_lock);
+
+  if (self->correlation_id) {
+    gst_clock_id_unschedule (self->correlation_id);
+    gst_clock_id_unref (self->correlation_id);
+    self->correlation_id = NULL;
+  }
+  if (self->correlation_clock) {
+    gst_object_unref (self->correlation_clock);
+    self->correlation_clock = NULL;
+  }
+
+  g_mutex_unlock (&self->correlation_lock);
+}
+
+/* Latch the camera time and fit it against the pipeline clock */
+static gboolean
+gst_pylon_src_correlate_timestamps (GstClock * clock, GstClockTime time,
+    GstClockID id, gpointer user_data)
+{
+  GstPylonSrc *self = GST_PYLON_SRC (user_data);
+  GError *error = NULL;
+  GstClockTime before = GST_CLOCK_TIME_NONE;
+  GstClockTime after = GST_CLOCK_TIME_NONE;
+  GstClockTime camera_time = GST_CLOCK_TIME_NONE;
+  GstClockTime *sample = NULL;
+  GstClockTime *previous = NULL;
+  GstClockTime internal = GST_CLOCK_TIME_NONE;
+  GstClockTime external = GST_CLOCK_TIME_NONE;
+  GstClockTime num = 1;
+  GstClockTime denom = 1;
+  guint64 ticks = 0;
+  gdouble r_squared = 0;
+
+  g_mutex_lock (&self->correlation_lock);
+
+  /* The correlation may have been stopped while this callback was due */
+  if (id != self->correlation_id) {
+    goto out;
+  }
+
+  before = gst_clock_get_time (clock);
+  if (!gst_pylon_latch_timestamp (self->pylon, &ticks, &error)) {
+    GST_ELEMENT_WARNING (self, LIBRARY, FAILED,
+        ("Unable to correlate camera timestamps, falling back to the "
+            "pipeline clock."), ("%s", error->message));
+    g_error_free (error);
+
+    GST_OBJECT_LOCK (self);
+    self->correlation_failed = TRUE;
+    GST_OBJECT_UNLOCK (self);
+
+    gst_clock_id_unschedule (id);
+    goto out;
+  }
+  after = gst_clock_get_time (clock);
+
+  /* The frequency is set before the correlation starts */
+  camera_time =
+      gst_util_uint64_scale (ticks, GST_SECOND, self->timestamp_frequency);
+
+  /* Samples taken before the camera clock was reset don't fit anymore */
+  if (self->n_correlation_samples > 0) {
+    previous = &self->correlation_samples[2 *
+        ((self->next_correlation_sample + TIMESTAMP_CORRELATION_SAMPLES - 1) %
+            TIMESTAMP_CORRELATION_SAMPLES)];
+    if (camera_time < previous[0]) {
+      GST_WARNING_OBJECT (self, "Camera clock went back from %"
+          GST_TIME_FORMAT " to %" GST_TIME_FORMAT ", restarting correlation",
+          GST_TIME_ARGS (previous[0]), GST_TIME_ARGS (camera_time));
+      self->n_correlation_samples = 0;
+      self->next_correlation_sample = 0;
+    }
+  }
+
+  /* The latch happened somewhere between both clock reads */
+  sample = &self->correlation_samples[2 * self->next_correlation_sample];
+  sample[0] = camera_time;
+  sample[1] = before + (after - before) / 2;
+
+  self->next_correlation_sample =
+      (self->next_correlation_sample + 1) % TIMESTAMP_CORRELATION_SAMPLES;
+  self->n_correlation_samples =
+      MIN (self->n_correlation_samples + 1, TIMESTAMP_CORRELATION_SAMPLES);
+
+  /* A single sample only gives the offset between both clocks */
+  if (self->n_correlation_samples < 2
+      || !gst_calculate_linear_regression (self->correlation_samples,
+          self->correlation_temp, self->n_correlation_samples, &num, &denom,
+          &external, &internal, &r_squared)) {
+    internal = sample[0];
+    external = sample[1];
+    num = 1;
+    denom = 1;
+  }
+
+  GST_OBJECT_LOCK (self);
+  self->correlation_internal = internal;
+  self->correlation_external = external;
+  self->correlation_num = num;
+  self->correlation_denom = denom;
+  self->correlation_valid = TRUE;
+  GST_OBJECT_UNLOCK (self);
+
+  GST_LOG_OBJECT (self, "Camera clock correlation %" GST_TIME_FORMAT " -> %"
+      GST_TIME_FORMAT " rate %" G_GUINT64_FORMAT "/%" G_GUINT64_FORMAT
+      " r^2 %f", GST_TIME_ARGS (internal), GST_TIME_ARGS (external), num,
+      denom, r_squared);
+
+out:
+  g_mutex_unlock (&self->correlation_lock);
+
+  return TRUE;
+}
+
+static GstClockTime
+gst_pylon_src_get_timestamp (GstPylonSrc * self, GstClock * clock,
+    GstClockTime base_time, guint64 camera_ticks)
+{
+  GstPylonTimestampModeEnum timestamp_mode = PROP_TIMESTAMP_MODE_DEFAULT;
+  GstClockTime abs_time = GST_CLOCK_TIME_NONE;
+  GstClockTime camera_time = GST_CLOCK_TIME_NONE;
+  GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+  GstClockTime internal = GST_CLOCK_TIME_NONE;
+  GstClockTime external = GST_CLOCK_TIME_NONE;
+  GstClockTime num = 1;
+  GstClockTime denom = 1;
+  gboolean correlated = FALSE;
+
+  /* no clock, can't set timestamps */
+  if (!clock) {
+    return GST_CLOCK_TIME_NONE;
+  }
+
+  GST_OBJECT_LOCK (self);
+  timestamp_mode = self->timestamp_mode;
+  GST_OBJECT_UNLOCK (self);
+
+  /* sample pipeline clock */
+  abs_time = gst_clock_get_time (clock);
+  timestamp = abs_time - base_time;
+
+  if (ENUM_TIMESTAMP_PIPELINE_CLOCK == timestamp_mode) {
+    return timestamp;
+  }
+
+  if (0 == self->timestamp_frequency) {
+    self->timestamp_frequency = gst_pylon_get_timestamp_frequency (self->pylon);
+  }
+  camera_time =
+      gst_util_uint64_scale (camera_ticks, GST_SECOND,
+      self->timestamp_frequency);
+
+  switch (timestamp_mode) {
+    case ENUM_TIMESTAMP_CAMERA:
+      /* Follow the camera clock from the running time of the first image */
+      if (GST_CLOCK_TIME_IS_VALID (self->first_camera_time)
+          && camera_time < self->first_camera_time) {
+        GST_WARNING_OBJECT (self, "Camera clock went back from %"
+            GST_TIME_FORMAT " to %" GST_TIME_FORMAT ", following it from "
+            "the current image", GST_TIME_ARGS (self->first_camera_time),
+            GST_TIME_ARGS (camera_time));
+        self->first_camera_time = GST_CLOCK_TIME_NONE;
+      }
+      if (!GST_CLOCK_TIME_IS_VALID (self->first_camera_time)) {
+        self->first_camera_time = camera_time;
+        self->first_running_time = timestamp;
+      }
+      timestamp =
+          self->first_running_time + camera_time - self->first_camera_time;
+      break;
+    case ENUM_TIMESTAMP_CAMERA_CORRELATED:
+      gst_pylon_src_start_correlation (self, clock);
+
+      /* Until the first latch the pipeline clock is used */
+      GST_OBJECT_LOCK (self);
+      correlated = self->correlation_valid && !self->correlation_failed;
+      internal = self->correlation_internal;
+      external = self->correlation_external;
+      num = self->correlation_num;
+      denom = self->correlation_denom;
+      GST_OBJECT_UNLOCK (self);
+
+      if (!correlated) {
+        break;
+      }
+      abs_time =
+          gst_clock_adjust_with_calibration (NULL, camera_time, internal,
+          external, num, denom);
+      timestamp = abs_time > base_time ? abs_time - base_time : 0;
+      break;
+    default:
+      break;
+  }
+
+  return timestamp;
+}
+
 /* ask the subclass to create a buffer with offset and size, the default
  * implementation will call alloc and fill. */
 static GstFlowReturn
@@ -867,12 +1606,15 @@ gst_pylon_src_create (GstPushSrc * src, GstBuffer ** buf)
   gboolean pylon_ret = TRUE;
   GstFlowReturn ret = GST_FLOW_OK;
   gint capture_error = -1;
+  gint chunk_decoding = -1;
 
   GST_OBJECT_LOCK (self);
   capture_error = self->capture_error;
+  chunk_decoding = self->chunk_decoding;
   GST_OBJECT_UNLOCK (self);
 
-  pylon_ret = gst_pylon_capture (self->pylon, buf, capture_error, &error);
+  pylon_ret = gst_pylon_capture (self->pylon, buf, capture_error,
+      chunk_decoding, &error);
 
   if (pylon_ret == FALSE) {
     if (error) {
@@ -0,0 +1,379 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstpylonunpack.h"
+#include "gstpylonsimd.h"
+
+#include <cstring>
+
+/* bits is the depth of the value, pixel_bits the space a pixel takes in the
+ * source */
+typedef struct {
+  const gchar *pfnc_name;
+  GstPylonUnpackFormat format;
+  guint bits;
+  guint pixel_bits;
+} GstPylonUnpackFormatInfo;
+
+static const GstPylonUnpackFormatInfo unpack_formats[] = {
+    {"Mono10p", GST_PYLON_UNPACK_MONO10P, 10, 10},
+    {"Mono12p", GST_PYLON_UNPACK_MONO12P, 12, 12},
+    {"Mono12Packed", GST_PYLON_UNPACK_MONO12_PACKED, 12, 12},
+    {"Mono10", GST_PYLON_UNPACK_MONO10, 10, 16},
+    {"Mono12", GST_PYLON_UNPACK_MONO12, 12, 16},
+    /* Bayer formats share the layout of the mono ones */
+    {"BayerBG10p", GST_PYLON_UNPACK_MONO10P, 10, 10},
+    {"BayerBG12p", GST_PYLON_UNPACK_MONO12P, 12, 12},
+    {"BayerBG12Packed", GST_PYLON_UNPACK_MONO12_PACKED, 12, 12},
+    {"BayerGR10p", GST_PYLON_UNPACK_MONO10P, 10, 10},
+    {"BayerGR12p", GST_PYLON_UNPACK_MONO12P, 12, 12},
+    {"BayerGR12Packed", GST_PYLON_UNPACK_MONO12_PACKED, 12, 12},
+    {"BayerRG10p", GST_PYLON_UNPACK_MONO10P, 10, 10},
+    {"BayerRG12p", GST_PYLON_UNPACK_MONO12P, 12, 12},
+    {"BayerRG12Packed", GST_PYLON_UNPACK_MONO12_PACKED, 12, 12},
+    {"BayerGB10p", GST_PYLON_UNPACK_MONO10P, 10, 10},
+    {"BayerGB12p", GST_PYLON_UNPACK_MONO12P, 12, 12},
+    {"BayerGB12Packed", GST_PYLON_UNPACK_MONO12_PACKED, 12, 12},
+};
+
+/* prototypes */
+static const GstPylonUnpackFormatInfo *gst_pylon_unpack_get_info(
+    GstPylonUnpackFormat format);
+static void gst_pylon_unpack_lsb_scalar(const guint8 *src, gsize bit_offset,
+                                        guint16 *dst, guint n_pixels,
+                                        guint bits, guint shift);
+static void gst_pylon_unpack_words_scalar(const guint8 *src, guint16 *dst,
+                                          guint n_pixels, guint bits,
+                                          guint shift);
+static void gst_pylon_unpack_mono12_packed_scalar(const guint8 *src,
+                                                  guint16 *dst,
+                                                  guint n_pixels, guint shift);
+static void gst_pylon_unpack_row(const GstPylonUnpackFormatInfo *info,
+                                 guint shift, const guint8 *src,
+                                 gsize src_size, guint16 *dst, guint width);
+
+GstPylonUnpackFormat gst_pylon_unpack_get_format(const gchar *pfnc_name) {
+  g_return_val_if_fail(pfnc_name, GST_PYLON_UNPACK_NONE);
+
+  for (const auto &info : unpack_formats) {
+    if (0 == strcmp(info.pfnc_name, pfnc_name)) {
+      return info.format;
+    }
+  }
+
+  return GST_PYLON_UNPACK_NONE;
+}
+
+static const GstPylonUnpackFormatInfo *gst_pylon_unpack_get_info(
+    GstPylonUnpackFormat format) {
+  for (const auto &info : unpack_formats) {
+    if (info.format == format) {
+      return &info;
+    }
+  }
+
+  return NULL;
+}
+
+/* PFNC "p" formats are a little endian bit stream, a pixel may start in the
+ * middle of a byte and always ends in the next one. Every kernel shifts the
+ * value left by shift to scale it. */
+static void gst_pylon_unpack_lsb_scalar(const guint8 *src, gsize bit_offset,
+                                        guint16 *dst, guint n_pixels,
+                                        guint bits, guint shift) {
+  const guint mask = (1 << bits) - 1;
+
+  for (guint i = 0; i < n_pixels; i++, bit_offset += bits) {
+    const guint8 *p = src + (bit_offset >> 3);
+    guint value = (p[0] | (p[1] << 8)) >> (bit_offset & 7);
+
+    dst[i] = GUINT16_TO_LE((value & mask) << shift);
+  }
+}
+
+/* Mono10 and Mono12 store every pixel in a little endian 16 bit word */
+static void gst_pylon_unpack_words_scalar(const guint8 *src, guint16 *dst,
+                                          guint n_pixels, guint bits,
+                                          guint shift) {
+  const guint mask = (1 << bits) - 1;
+
+  for (guint i = 0; i < n_pixels; i++, src += 2) {
+    guint value = src[0] | (src[1] << 8);
+
+    dst[i] = GUINT16_TO_LE((value & mask) << shift);
+  }
+}
+
+/* Mono12Packed stores the 8 most significant bits of two pixels in the outer
+ * bytes of a 3 byte group and both low nibbles in the middle byte */
+static void gst_pylon_unpack_mono12_packed_scalar(const guint8 *src,
+                                                  guint16 *dst,
+                                                  guint n_pixels,
+                                                  guint shift) {
+  guint i = 0;
+
+  for (; i + 1 < n_pixels; i += 2, src += 3) {
+    dst[i] = GUINT16_TO_LE(((src[0] << 4) | (src[1] & 0x0f)) << shift);
+    dst[i + 1] = GUINT16_TO_LE(((src[2] << 4) | (src[1] >> 4)) << shift);
+  }
+
+  if (i < n_pixels) {
+    dst[i] = GUINT16_TO_LE(((src[0] << 4) | (src[1] & 0x0f)) << shift);
+  }
+}
+
+#ifdef GST_PYLON_SIMD_AVX2
+/* Every 128 bit lane unpacks 8 pixels. The shuffle moves the two bytes
+ * holding a pixel into its 16 bit word. For the PFNC formats the multiply
+ * aligns the pixel bits to the top of the word and the shift moves them back
+ * down, dropping the bits of the neighbors. Returns the number of pixels
+ * unpacked, always a multiple of 16. */
+__attribute__((target("avx2"))) static guint gst_pylon_unpack_row_avx2(
+    GstPylonUnpackFormat format, guint msb_shift, const guint8 *src,
+    gsize src_size, guint16 *dst, guint width) {
+  __m256i shuffle;
+  __m256i multiplier = _mm256_set1_epi16(1);
+  __m128i shift = _mm_cvtsi32_si128(0);
+  const __m128i scale = _mm_cvtsi32_si128(msb_shift);
+  const __m256i high_mask =
+      _mm256_setr_epi16(0x0ff0, -1, 0x0ff0, -1, 0x0ff0, -1, 0x0ff0, -1,
+                        0x0ff0, -1, 0x0ff0, -1, 0x0ff0, -1, 0x0ff0, -1);
+  const __m256i low_mask =
+      _mm256_setr_epi16(0x000f, 0, 0x000f, 0, 0x000f, 0, 0x000f, 0, 0x000f,
+                        0, 0x000f, 0, 0x000f, 0, 0x000f, 0);
+  gsize lane_bytes = 12;
+  gsize offset = 0;
+  guint i = 0;
+
+  switch (format) {
+    case GST_PYLON_UNPACK_MONO10P:
+      shuffle = _mm256_setr_epi8(0, 1, 1, 2, 2, 3, 3, 4, 5, 6, 6, 7, 7, 8, 8,
+                                 9, 0, 1, 1, 2, 2, 3, 3, 4, 5, 6, 6, 7, 7, 8,
+                                 8, 9);
+      multiplier = _mm256_setr_epi16(64, 16, 4, 1, 64, 16, 4, 1, 64, 16, 4, 1,
+                                     64, 16, 4, 1);
+      shift = _mm_cvtsi32_si128(6);
+      lane_bytes = 10;
+      break;
+    case GST_PYLON_UNPACK_MONO12P:
+      shuffle = _mm256_setr_epi8(0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8, 9, 10,
+                                 10, 11, 0, 1, 1, 2, 3, 4, 4, 5, 6, 7, 7, 8,
+                                 9, 10, 10, 11);
+      multiplier = _mm256_setr_epi16(16, 1, 16, 1, 16, 1, 16, 1, 16, 1, 16, 1,
+                                     16, 1, 16, 1);
+      shift = _mm_cvtsi32_si128(4);
+      break;
+    case GST_PYLON_UNPACK_MONO12_PACKED:
+      shuffle = _mm256_setr_epi8(1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9,
+                                 10, 11, 1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8,
+                                 10, 9, 10, 11);
+      break;
+    default:
+      return 0;
+  }
+
+  /* Both lanes are loaded with 16 bytes, stay inside the source */
+  for (; i + 16 <= width && offset + lane_bytes + 16 <= src_size;
+       i += 16, offset += 2 * lane_bytes) {
+    __m128i lo = _mm_loadu_si128((const __m128i *)(src + offset));
+    __m128i hi = _mm_loadu_si128((const __m128i *)(src + offset + lane_bytes));
+    __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+    v = _mm256_shuffle_epi8(v, shuffle);
+
+    if (GST_PYLON_UNPACK_MONO12_PACKED == format) {
+      /* Even words hold the high byte of the pixel above the shared byte,
+       * odd words the shared byte below the high byte */
+      __m256i high = _mm256_srli_epi16(v, 4);
+      v = _mm256_or_si256(_mm256_and_si256(high, high_mask),
+                          _mm256_and_si256(v, low_mask));
+    } else {
+      v = _mm256_srl_epi16(_mm256_mullo_epi16(v, multiplier), shift);
+    }
+
+    v = _mm256_sll_epi16(v, scale);
+    _mm256_storeu_si256((__m256i *)(dst + i), v);
+  }
+
+  return i;
+}
+#endif
+
+#ifdef GST_PYLON_SIMD_NEON
+/* Mono10p packs 4 pixels in 5 bytes, it is unpacked 8 pixels at a time
+ * with a table lookup like the AVX2 kernel. The 12 bit formats pack 2 pixels
+ * in 3 bytes, which the structure load deinterleaves into one vector per
+ * byte of the group. Returns the number of pixels unpacked. */
+static guint gst_pylon_unpack_row_neon(GstPylonUnpackFormat format,
+                                       guint msb_shift, const guint8 *src,
+                                       gsize src_size, guint16 *dst,
+                                       guint width) {
+  const int16x8_t scale = vdupq_n_s16(msb_shift);
+  gsize offset = 0;
+  guint i = 0;
+
+  if (GST_PYLON_UNPACK_MONO10P == format) {
+    static const guint8 shuffle_bytes[16] = {0, 1, 1, 2, 2, 3, 3, 4,
+                                             5, 6, 6, 7, 7, 8, 8, 9};
+    static const guint16 multiplier_words[8] = {64, 16, 4, 1, 64, 16, 4, 1};
+    const uint8x16_t shuffle = vld1q_u8(shuffle_bytes);
+    const uint16x8_t multiplier = vld1q_u16(multiplier_words);
+
+    for (; i + 8 <= width && offset + 16 <= src_size; i += 8, offset += 10) {
+      uint8x16_t v = vqtbl1q_u8(vld1q_u8(src + offset), shuffle);
+      uint16x8_t p = vmulq_u16(vreinterpretq_u16_u8(v), multiplier);
+
+      vst1q_u16(dst + i, vshlq_u16(vshrq_n_u16(p, 6), scale));
+    }
+
+    return i;
+  }
+
+  if (GST_PYLON_UNPACK_MONO12P != format &&
+      GST_PYLON_UNPACK_MONO12_PACKED != format) {
+    return 0;
+  }
+
+  const uint16x8_t low_nibble = vdupq_n_u16(0x0f);
+
+  for (; i + 16 <= width && offset + 24 <= src_size; i += 16, offset += 24) {
+    uint8x8x3_t group = vld3_u8(src + offset);
+    uint16x8_t b0 = vmovl_u8(group.val[0]);
+    uint16x8_t b1 = vmovl_u8(group.val[1]);
+    uint16x8_t b2 = vmovl_u8(group.val[2]);
+    uint16x8x2_t p;
+
+    if (GST_PYLON_UNPACK_MONO12P == format) {
+      p.val[0] = vorrq_u16(b0, vshlq_n_u16(vandq_u16(b1, low_nibble), 8));
+      p.val[1] = vorrq_u16(vshrq_n_u16(b1, 4), vshlq_n_u16(b2, 4));
+    } else {
+      p.val[0] = vorrq_u16(vshlq_n_u16(b0, 4), vandq_u16(b1, low_nibble));
+      p.val[1] = vorrq_u16(vshlq_n_u16(b2, 4), vshrq_n_u16(b1, 4));
+    }
+
+    p.val[0] = vshlq_u16(p.val[0], scale);
+    p.val[1] = vshlq_u16(p.val[1], scale);
+
+    /* Interleaves the even and odd pixels back into place */
+    vst2q_u16(dst + i, p);
+  }
+
+  return i;
+}
+#endif
+
+static void gst_pylon_unpack_row(const GstPylonUnpackFormatInfo *info,
+                                 guint shift, const guint8 *src,
+                                 gsize src_size, guint16 *dst, guint width) {
+  guint done = 0;
+
+#ifdef GST_PYLON_SIMD_AVX2
+  if (gst_pylon_simd_have_avx2()) {
+    done = gst_pylon_unpack_row_avx2(info->format, shift, src, src_size, dst,
+                                     width);
+  }
+#endif
+#ifdef GST_PYLON_SIMD_NEON
+  done = gst_pylon_unpack_row_neon(info->format, shift, src, src_size, dst,
+                                   width);
+#endif
+
+  /* The vector kernels stop at a group boundary, which starts at a byte */
+  src += (gsize)done * info->pixel_bits / 8;
+
+  switch (info->format) {
+    case GST_PYLON_UNPACK_MONO12_PACKED:
+      gst_pylon_unpack_mono12_packed_scalar(src, dst + done, width - done,
+                                            shift);
+      break;
+    case GST_PYLON_UNPACK_MONO10:
+    case GST_PYLON_UNPACK_MONO12:
+      gst_pylon_unpack_words_scalar(src, dst + done, width - done, info->bits,
+                                    shift);
+      break;
+    default:
+      gst_pylon_unpack_lsb_scalar(src, 0, dst + done, width - done,
+                                  info->bits, shift);
+      break;
+  }
+}
+
+gboolean gst_pylon_unpack(GstPylonUnpackFormat format, gboolean msb,
+                          const guint8 *src, gsize src_size, gsize src_stride,
+                          guint8 *dst, gsize dst_stride, guint width,
+                          guint height) {
+  const GstPylonUnpackFormatInfo *info = gst_pylon_unpack_get_info(format);
+
+  g_return_val_if_fail(info, FALSE);
+  g_return_val_if_fail(src, FALSE);
+  g_return_val_if_fail(dst, FALSE);
+
+  if (0 == width || 0 == height) {
+    return TRUE;
+  }
+
+  guint shift = msb ? 16 - info->bits : 0;
+  gsize row_bits = (gsize)width * info->pixel_bits;
+  gsize row_bytes = (row_bits + 7) / 8;
+
+  /* PFNC formats don't pad lines, so a line only starts at a byte if its
+   * bit count is a multiple of 8. Mono12Packed lines always do. */
+  if (GST_PYLON_UNPACK_MONO12_PACKED == format || 0 == row_bits % 8) {
+    src_stride = MAX(src_stride, row_bytes);
+    if (src_size < src_stride * (height - 1) + row_bytes) {
+      return FALSE;
+    }
+
+    for (guint row = 0; row < height; row++) {
+      gsize src_offset = row * src_stride;
+      gst_pylon_unpack_row(info, shift, src + src_offset,
+                           src_size - src_offset,
+                           (guint16 *)(dst + row * dst_stride), width);
+    }
+  } else {
+    if (src_size < (row_bits * height + 7) / 8) {
+      return FALSE;
+    }
+
+    for (guint row = 0; row < height; row++) {
+      gst_pylon_unpack_lsb_scalar(src, row * row_bits,
+                                  (guint16 *)(dst + row * dst_stride), width,
+                                  info->bits, shift);
+    }
+  }
+
+  return TRUE;
+}
@@ -0,0 +1,63 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GST_PYLON_UNPACK_H_
+#define _GST_PYLON_UNPACK_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Packed layouts transferred over the wire and unpacked to one pixel per
+ * little endian 16 bit word, Bayer formats use the layout of the mono format
+ * with the same suffix. Mono10 and Mono12 already come as 16 bit words with
+ * the value in the low bits, they are only unpacked to scale them. */
+typedef enum {
+  GST_PYLON_UNPACK_NONE = 0,
+  GST_PYLON_UNPACK_MONO10P = 1,
+  GST_PYLON_UNPACK_MONO12P = 2,
+  GST_PYLON_UNPACK_MONO12_PACKED = 3,
+  GST_PYLON_UNPACK_MONO10 = 4,
+  GST_PYLON_UNPACK_MONO12 = 5,
+} GstPylonUnpackFormat;
+
+/* The value is kept in the low bits of the word unless msb is set, which
+ * moves it to the high bits as full scale formats like GRAY16_LE expect */
+GstPylonUnpackFormat gst_pylon_unpack_get_format(const gchar *pfnc_name);
+gboolean gst_pylon_unpack(GstPylonUnpackFormat format, gboolean msb,
+                          const guint8 *src, gsize src_size, gsize src_stride,
+                          guint8 *dst, gsize dst_stride, guint width,
+                          guint height);
+
+G_END_DECLS
+
+#endif
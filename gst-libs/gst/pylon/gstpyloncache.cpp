@@ -0,0 +1,242 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstpyloncache.h"
+#include "gstpylondebug.h"
+
+#define CACHE_DIR_NAME "gstpylon"
+#define CACHE_FILE_EXTENSION ".cache"
+#define CACHE_HEADER_GROUP "cache"
+#define CACHE_VERSION_KEY "version"
+#define CACHE_VALID_CHARS G_CSET_a_2_z G_CSET_A_2_Z G_CSET_DIGITS "-_."
+
+#define KEY_MIN "min"
+#define KEY_MAX "max"
+#define KEY_FLAGS "flags"
+#define KEY_ENUM_VALUES "enum-values"
+#define KEY_ENUM_NAMES "enum-names"
+#define KEY_ENUM_TOOLTIPS "enum-tooltips"
+
+GstPylonCache::GstPylonCache(const std::string &name)
+    : keyfile(g_key_file_new()), dirty(FALSE) {
+  gchar *basename = g_strconcat(name.c_str(), CACHE_FILE_EXTENSION, NULL);
+  g_strcanon(basename, CACHE_VALID_CHARS, '_');
+
+  this->filename = g_build_filename(g_get_user_cache_dir(), CACHE_DIR_NAME,
+                                    basename, NULL);
+  g_free(basename);
+}
+
+GstPylonCache::~GstPylonCache() {
+  g_key_file_free(this->keyfile);
+  g_free(this->filename);
+}
+
+void GstPylonCache::load() {
+  GError *error = NULL;
+
+  if (!g_key_file_load_from_file(this->keyfile, this->filename,
+                                 G_KEY_FILE_NONE, &error)) {
+    GST_DEBUG("No feature cache loaded from \"%s\": %s", this->filename,
+              error->message);
+    g_error_free(error);
+    return;
+  }
+
+  /* Results of an older plugin version might have been computed
+   * differently, start from scratch in that case */
+  gchar *version = g_key_file_get_string(this->keyfile, CACHE_HEADER_GROUP,
+                                         CACHE_VERSION_KEY, NULL);
+  if (g_strcmp0(version, VERSION) != 0) {
+    GST_INFO("Discarding feature cache \"%s\" of version \"%s\"",
+             this->filename, GST_STR_NULL(version));
+    g_key_file_free(this->keyfile);
+    this->keyfile = g_key_file_new();
+  } else {
+    GST_DEBUG("Loaded feature cache from \"%s\"", this->filename);
+  }
+
+  g_free(version);
+}
+
+void GstPylonCache::save() {
+  GError *error = NULL;
+
+  if (!this->dirty) {
+    return;
+  }
+
+  gchar *dirname = g_path_get_dirname(this->filename);
+  g_mkdir_with_parents(dirname, 0755);
+  g_free(dirname);
+
+  g_key_file_set_string(this->keyfile, CACHE_HEADER_GROUP, CACHE_VERSION_KEY,
+                        VERSION);
+
+  if (!g_key_file_save_to_file(this->keyfile, this->filename, &error)) {
+    GST_WARNING("Unable to save feature cache to \"%s\": %s", this->filename,
+                error->message);
+    g_error_free(error);
+    return;
+  }
+
+  GST_DEBUG("Saved feature cache to \"%s\"", this->filename);
+  this->dirty = FALSE;
+}
+
+gboolean GstPylonCache::get_int_limits(const gchar *feature, gint64 &min_value,
+                                       gint64 &max_value) {
+  g_return_val_if_fail(feature, FALSE);
+
+  if (!g_key_file_has_key(this->keyfile, feature, KEY_MIN, NULL) ||
+      !g_key_file_has_key(this->keyfile, feature, KEY_MAX, NULL)) {
+    return FALSE;
+  }
+
+  min_value = g_key_file_get_int64(this->keyfile, feature, KEY_MIN, NULL);
+  max_value = g_key_file_get_int64(this->keyfile, feature, KEY_MAX, NULL);
+
+  return TRUE;
+}
+
+void GstPylonCache::set_int_limits(const gchar *feature, gint64 min_value,
+                                   gint64 max_value) {
+  g_return_if_fail(feature);
+
+  g_key_file_set_int64(this->keyfile, feature, KEY_MIN, min_value);
+  g_key_file_set_int64(this->keyfile, feature, KEY_MAX, max_value);
+  this->dirty = TRUE;
+}
+
+gboolean GstPylonCache::get_double_limits(const gchar *feature,
+                                          gdouble &min_value,
+                                          gdouble &max_value) {
+  g_return_val_if_fail(feature, FALSE);
+
+  if (!g_key_file_has_key(this->keyfile, feature, KEY_MIN, NULL) ||
+      !g_key_file_has_key(this->keyfile, feature, KEY_MAX, NULL)) {
+    return FALSE;
+  }
+
+  min_value = g_key_file_get_double(this->keyfile, feature, KEY_MIN, NULL);
+  max_value = g_key_file_get_double(this->keyfile, feature, KEY_MAX, NULL);
+
+  return TRUE;
+}
+
+void GstPylonCache::set_double_limits(const gchar *feature, gdouble min_value,
+                                      gdouble max_value) {
+  g_return_if_fail(feature);
+
+  g_key_file_set_double(this->keyfile, feature, KEY_MIN, min_value);
+  g_key_file_set_double(this->keyfile, feature, KEY_MAX, max_value);
+  this->dirty = TRUE;
+}
+
+gboolean GstPylonCache::get_flags(const gchar *feature, GParamFlags &flags) {
+  g_return_val_if_fail(feature, FALSE);
+
+  if (!g_key_file_has_key(this->keyfile, feature, KEY_FLAGS, NULL)) {
+    return FALSE;
+  }
+
+  flags = static_cast<GParamFlags>(
+      g_key_file_get_integer(this->keyfile, feature, KEY_FLAGS, NULL));
+
+  return TRUE;
+}
+
+void GstPylonCache::set_flags(const gchar *feature, GParamFlags flags) {
+  g_return_if_fail(feature);
+
+  g_key_file_set_integer(this->keyfile, feature, KEY_FLAGS, flags);
+  this->dirty = TRUE;
+}
+
+gboolean GstPylonCache::get_enum_entries(
+    const gchar *feature, std::vector<GstPylonCacheEnumEntry> &entries) {
+  gsize n_values = 0;
+  gsize n_names = 0;
+  gsize n_tooltips = 0;
+  gboolean ret = FALSE;
+
+  g_return_val_if_fail(feature, FALSE);
+
+  gint *values = g_key_file_get_integer_list(this->keyfile, feature,
+                                             KEY_ENUM_VALUES, &n_values, NULL);
+  gchar **names = g_key_file_get_string_list(this->keyfile, feature,
+                                             KEY_ENUM_NAMES, &n_names, NULL);
+  gchar **tooltips = g_key_file_get_string_list(
+      this->keyfile, feature, KEY_ENUM_TOOLTIPS, &n_tooltips, NULL);
+
+  if (values && names && tooltips && n_values == n_names &&
+      n_values == n_tooltips) {
+    entries.clear();
+    for (gsize i = 0; i < n_values; i++) {
+      entries.push_back({values[i], names[i], tooltips[i]});
+    }
+    ret = TRUE;
+  }
+
+  g_free(values);
+  g_strfreev(names);
+  g_strfreev(tooltips);
+
+  return ret;
+}
+
+void GstPylonCache::set_enum_entries(
+    const gchar *feature, const std::vector<GstPylonCacheEnumEntry> &entries) {
+  std::vector<gint> values;
+  std::vector<const gchar *> names;
+  std::vector<const gchar *> tooltips;
+
+  g_return_if_fail(feature);
+
+  for (const auto &entry : entries) {
+    values.push_back(entry.value);
+    names.push_back(entry.name.c_str());
+    tooltips.push_back(entry.tooltip.c_str());
+  }
+
+  g_key_file_set_integer_list(this->keyfile, feature, KEY_ENUM_VALUES,
+                              values.data(), values.size());
+  g_key_file_set_string_list(this->keyfile, feature, KEY_ENUM_NAMES,
+                             names.data(), names.size());
+  g_key_file_set_string_list(this->keyfile, feature, KEY_ENUM_TOOLTIPS,
+                             tooltips.data(), tooltips.size());
+  this->dirty = TRUE;
+}
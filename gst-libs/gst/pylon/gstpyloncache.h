@@ -0,0 +1,83 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GST_PYLON_CACHE_H_
+#define _GST_PYLON_CACHE_H_
+
+#include <gst/gst.h>
+
+#include <string>
+#include <vector>
+
+struct GstPylonCacheEnumEntry {
+  gint value;
+  std::string name;
+  std::string tooltip;
+};
+
+/* Persistent store for the results of the feature introspection. The
+ * limits, access flags and enum entries of a device only depend on its
+ * model, firmware and the pylon version, so they are kept on disk and
+ * reused instead of exploring the nodemap again on every startup. */
+class GstPylonCache {
+ public:
+  explicit GstPylonCache(const std::string &name);
+  ~GstPylonCache();
+
+  void load();
+  void save();
+
+  gboolean get_int_limits(const gchar *feature, gint64 &min_value,
+                          gint64 &max_value);
+  void set_int_limits(const gchar *feature, gint64 min_value,
+                      gint64 max_value);
+  gboolean get_double_limits(const gchar *feature, gdouble &min_value,
+                             gdouble &max_value);
+  void set_double_limits(const gchar *feature, gdouble min_value,
+                         gdouble max_value);
+  gboolean get_flags(const gchar *feature, GParamFlags &flags);
+  void set_flags(const gchar *feature, GParamFlags flags);
+  gboolean get_enum_entries(const gchar *feature,
+                            std::vector<GstPylonCacheEnumEntry> &entries);
+  void set_enum_entries(const gchar *feature,
+                        const std::vector<GstPylonCacheEnumEntry> &entries);
+
+ private:
+  GstPylonCache(const GstPylonCache &) = delete;
+  GstPylonCache &operator=(const GstPylonCache &) = delete;
+
+  gchar *filename;
+  GKeyFile *keyfile;
+  gboolean dirty;
+};
+
+#endif
@@ -50,10 +50,12 @@ static std::vector<std::string> gst_pylon_get_int_entries(
     GenApi::IInteger* int_node);
 static std::vector<GParamSpec*> gst_pylon_camera_handle_node(
     GenApi::INode* node, GenApi::INodeMap& nodemap,
-    const gchar* device_fullname);
+    const gchar* device_fullname, GstPylonCache& cache);
 static void gst_pylon_camera_install_specs(
     const std::vector<GParamSpec*>& specs_list, GObjectClass* oclass,
     gint& nprop);
+static std::vector<GenApi::INode*> gst_pylon_find_feature_nodes(
+    GenApi::INodeMap& nodemap);
 
 static std::unordered_set<std::string> propfilter_set = {
     "Width",
@@ -167,7 +169,7 @@ std::vector<std::string> gst_pylon_process_selector_features(
 
 static std::vector<GParamSpec*> gst_pylon_camera_handle_node(
     GenApi::INode* node, GenApi::INodeMap& nodemap,
-    const gchar* device_fullname) {
+    const gchar* device_fullname, GstPylonCache& cache) {
   GenApi::INode* selector_node = NULL;
   guint64 selector_value = 0;
   std::vector<GParamSpec*> specs_list;
@@ -199,7 +201,8 @@ static std::vector<GParamSpec*> gst_pylon_camera_handle_node(
       }
     }
     specs_list.push_back(GstPylonParamFactory::make_param(
-        nodemap, node, selector_node, selector_value, device_fullname));
+        nodemap, node, selector_node, selector_value, device_fullname,
+        cache));
   }
 
   return specs_list;
@@ -226,14 +229,11 @@ static void gst_pylon_camera_install_specs(
   }
 }
 
-void GstPylonFeatureWalker::install_properties(GObjectClass* oclass,
-                                               GenApi::INodeMap& nodemap,
-                                               const gchar* device_fullname) {
-  g_return_if_fail(oclass);
-
-  gint nprop = 1;
+static std::vector<GenApi::INode*> gst_pylon_find_feature_nodes(
+    GenApi::INodeMap& nodemap) {
   GenApi::INode* root_node = nodemap.GetNode("Root");
   auto worklist = std::queue<GenApi::INode*>();
+  std::vector<GenApi::INode*> feature_nodes;
 
   worklist.push(root_node);
 
@@ -249,18 +249,7 @@ void GstPylonFeatureWalker::install_properties(GObjectClass* oclass,
         propfilter_set.find(std::string(node->GetName())) ==
             propfilter_set.end() &&
         node->GetPrincipalInterfaceType() != GenApi::intfICategory) {
-      GenICam::gcstring value;
-      GenICam::gcstring attrib;
-
-      try {
-        std::vector<GParamSpec*> specs_list =
-            gst_pylon_camera_handle_node(node, nodemap, device_fullname);
-        gst_pylon_camera_install_specs(specs_list, oclass, nprop);
-      } catch (const Pylon::GenericException& e) {
-        GST_FIXME("Unable to install property \"%s\" on device \"%s\": %s",
-                  node->GetDisplayName().c_str(), device_fullname,
-                  e.GetDescription());
-      }
+      feature_nodes.push_back(node);
     }
 
     /* Walk down all categories */
@@ -273,4 +262,52 @@ void GstPylonFeatureWalker::install_properties(GObjectClass* oclass,
       }
     }
   }
+
+  return feature_nodes;
+}
+
+void GstPylonFeatureWalker::fill_cache(GenApi::INodeMap& nodemap,
+                                       const gchar* device_fullname,
+                                       GstPylonCache& cache) {
+  std::vector<GenApi::INode*> feature_nodes =
+      gst_pylon_find_feature_nodes(nodemap);
+
+  try {
+    GstPylonParamFactory::prefetch_access(nodemap, feature_nodes, cache);
+  } catch (const Pylon::GenericException& e) {
+    GST_WARNING("Unable to query feature access on device \"%s\": %s",
+                device_fullname, e.GetDescription());
+  }
+}
+
+void GstPylonFeatureWalker::install_properties(GObjectClass* oclass,
+                                               GenApi::INodeMap& nodemap,
+                                               const gchar* device_fullname,
+                                               GstPylonCache& cache) {
+  g_return_if_fail(oclass);
+
+  gint nprop = 1;
+  std::vector<GenApi::INode*> feature_nodes =
+      gst_pylon_find_feature_nodes(nodemap);
+
+  /* Query the access flags of all features with a single lock of the
+   * transport layer parameters */
+  try {
+    GstPylonParamFactory::prefetch_access(nodemap, feature_nodes, cache);
+  } catch (const Pylon::GenericException& e) {
+    GST_WARNING("Unable to query feature access on device \"%s\": %s",
+                device_fullname, e.GetDescription());
+  }
+
+  for (const auto& node : feature_nodes) {
+    try {
+      std::vector<GParamSpec*> specs_list =
+          gst_pylon_camera_handle_node(node, nodemap, device_fullname, cache);
+      gst_pylon_camera_install_specs(specs_list, oclass, nprop);
+    } catch (const Pylon::GenericException& e) {
+      GST_FIXME("Unable to install property \"%s\" on device \"%s\": %s",
+                node->GetDisplayName().c_str(), device_fullname,
+                e.GetDescription());
+    }
+  }
 }
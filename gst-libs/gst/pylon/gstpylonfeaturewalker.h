@@ -33,6 +33,8 @@
 #ifndef _GST_PYLON_FEATURE_WALKER_H_
 #define _GST_PYLON_FEATURE_WALKER_H_
 
+#include "gstpyloncache.h"
+
 #include <gst/gst.h>
 
 #ifdef _MSC_VER  // MSVC
@@ -57,7 +59,13 @@ class GstPylonFeatureWalker {
  public:
   static void install_properties(GObjectClass* oclass,
                                  GenApi::INodeMap& nodemap,
-                                 const gchar* device_fullname);
+                                 const gchar* device_fullname,
+                                 GstPylonCache& cache);
+  /* Queries the access flags of the features that install_properties would
+   * install and stores them in the cache, without creating any param spec.
+   * Limits are only explored once a property is written. */
+  static void fill_cache(GenApi::INodeMap& nodemap,
+                         const gchar* device_fullname, GstPylonCache& cache);
 };
 
 std::vector<std::string> gst_pylon_process_selector_features(
@@ -34,11 +34,14 @@
 #include "config.h"
 #endif
 
+#include "gstpyloncache.h"
 #include "gstpylondebug.h"
 #include "gstpylonintrospection.h"
 #include "gstpylonparamspecs.h"
 
 #include <algorithm>
+#include <map>
+#include <mutex>
 #include <numeric>
 #include <set>
 #include <unordered_map>
@@ -47,6 +50,8 @@
 class GstPylonActions {
  public:
   void virtual set_value() = 0;
+  virtual GenApi::INode *get_node() = 0;
+  virtual bool has_value_of(GstPylonActions *other) = 0;
   virtual ~GstPylonActions() = default;
 };
 
@@ -58,6 +63,11 @@ class GstPylonTypeAction : public GstPylonActions {
     this->value = value;
   }
   void set_value() override { this->param.SetValue(this->value); }
+  GenApi::INode *get_node() override { return this->param.GetNode(); }
+  bool has_value_of(GstPylonActions *other) override {
+    auto typed = dynamic_cast<GstPylonTypeAction<P, V> *>(other);
+    return typed && typed->value == this->value;
+  }
 
  private:
   P param;
@@ -66,38 +76,41 @@ class GstPylonTypeAction : public GstPylonActions {
 
 /* prototypes */
 static GParamSpec *gst_pylon_make_spec_int64(GenApi::INodeMap &nodemap,
-                                             GenApi::INode *node);
-static GParamSpec *gst_pylon_make_spec_selector_int64(GenApi::INodeMap &nodemap,
-                                                      GenApi::INode *node,
-                                                      GenApi::INode *selector,
-                                                      guint64 selector_value);
+                                             GenApi::INode *node,
+                                             GstPylonCache &cache);
+static GParamSpec *gst_pylon_make_spec_selector_int64(
+    GenApi::INodeMap &nodemap, GenApi::INode *node, GenApi::INode *selector,
+    guint64 selector_value, GstPylonCache &cache);
 static GParamSpec *gst_pylon_make_spec_bool(GenApi::INodeMap &nodemap,
-                                            GenApi::INode *node);
-static GParamSpec *gst_pylon_make_spec_selector_bool(GenApi::INodeMap &nodemap,
-                                                     GenApi::INode *node,
-                                                     GenApi::INode *selector,
-                                                     guint64 selector_value);
+                                            GenApi::INode *node,
+                                            GstPylonCache &cache);
+static GParamSpec *gst_pylon_make_spec_selector_bool(
+    GenApi::INodeMap &nodemap, GenApi::INode *node, GenApi::INode *selector,
+    guint64 selector_value, GstPylonCache &cache);
 static GParamSpec *gst_pylon_make_spec_float(GenApi::INodeMap &nodemap,
-                                             GenApi::INode *node);
-static GParamSpec *gst_pylon_make_spec_selector_float(GenApi::INodeMap &nodemap,
-                                                      GenApi::INode *node,
-                                                      GenApi::INode *selector,
-                                                      guint64 selector_value);
+                                             GenApi::INode *node,
+                                             GstPylonCache &cache);
+static GParamSpec *gst_pylon_make_spec_selector_float(
+    GenApi::INodeMap &nodemap, GenApi::INode *node, GenApi::INode *selector,
+    guint64 selector_value, GstPylonCache &cache);
 static GParamSpec *gst_pylon_make_spec_str(GenApi::INodeMap &nodemap,
-                                           GenApi::INode *node);
-static GParamSpec *gst_pylon_make_spec_selector_str(GenApi::INodeMap &nodemap,
-                                                    GenApi::INode *node,
-                                                    GenApi::INode *selector,
-                                                    guint64 selector_value);
+                                           GenApi::INode *node,
+                                           GstPylonCache &cache);
+static GParamSpec *gst_pylon_make_spec_selector_str(
+    GenApi::INodeMap &nodemap, GenApi::INode *node, GenApi::INode *selector,
+    guint64 selector_value, GstPylonCache &cache);
 static GType gst_pylon_make_enum_type(GenApi::INodeMap &nodemap,
                                       GenApi::INode *node,
-                                      const gchar *device_fullname);
+                                      const gchar *device_fullname,
+                                      GstPylonCache &cache);
 static GParamSpec *gst_pylon_make_spec_enum(GenApi::INodeMap &nodemap,
                                             GenApi::INode *node,
-                                            const gchar *device_fullname);
+                                            const gchar *device_fullname,
+                                            GstPylonCache &cache);
 static GParamSpec *gst_pylon_make_spec_selector_enum(
     GenApi::INodeMap &nodemap, GenApi::INode *node, GenApi::INode *selector,
-    guint64 selector_value, const gchar *device_fullname);
+    guint64 selector_value, const gchar *device_fullname,
+    GstPylonCache &cache);
 static GenApi::INode *gst_pylon_find_limit_node(GenApi::INode *feature_node,
                                                 const GenICam::gcstring &limit);
 static std::vector<GenApi::INode *> gst_pylon_find_parent_features(
@@ -107,9 +120,13 @@ static void gst_pylon_add_all_property_values(
     std::unordered_map<std::string, GenApi::INode *> &invalidators);
 static std::vector<GenApi::INode *> gst_pylon_get_available_features(
     const std::set<GenApi::INode *> &feature_list);
-template <class Type>
-static std::vector<std::vector<Type>> gst_pylon_cartesian_product(
-    std::vector<std::vector<Type>> &v);
+static std::set<GenApi::INode *> gst_pylon_find_influencing_features(
+    GenApi::INode *feature_node);
+static std::set<GenApi::INode *> gst_pylon_find_influencing_features(
+    GenApi::INode *feature_node,
+    const std::vector<GenApi::INode *> &candidates);
+static std::vector<std::vector<gsize>> gst_pylon_group_features(
+    const std::vector<GenApi::INode *> &feature_list);
 template <class P, class T>
 static T gst_pylon_check_for_feature_invalidators(
     GenApi::INode *feature_node, GenApi::INode *limit_node, std::string limit,
@@ -126,8 +143,119 @@ static void gst_pylon_find_limits(
     double &maximum_under_all_settings,
     std::vector<GenApi::INode *> &invalidators_result);
 static gboolean gst_pylon_can_feature_later_be_writable(GenApi::INode *node);
+static GParamFlags gst_pylon_query_static_access(GenApi::INode *node,
+                                                 gboolean &check_mutability);
 static GParamFlags gst_pylon_query_access(GenApi::INodeMap &nodemap,
                                           GenApi::INode *node);
+static GParamFlags gst_pylon_get_access(GenApi::INodeMap &nodemap,
+                                        GenApi::INode *node,
+                                        GstPylonCache &cache);
+static gboolean gst_pylon_get_int64_limits(GenApi::INode *node,
+                                           gint64 &min_value, gint64 &max_value,
+                                           GstPylonCache &cache);
+static gboolean gst_pylon_get_float_limits(GenApi::INode *node,
+                                           gdouble &min_value,
+                                           gdouble &max_value,
+                                           GstPylonCache &cache);
+static GQuark gst_pylon_param_spec_provisional_quark();
+static GParamSpec *gst_pylon_param_spec_mark_provisional(GParamSpec *spec,
+                                                         gboolean exact);
+
+/* Queues the writes of the limit exploration. Pending writes to the same
+ * feature are coalesced, and writes of the value the batch last wrote to or
+ * read from a feature are skipped without going to the device. A write
+ * forgets the known value of every feature it invalidates. */
+class GstPylonWriteBatch {
+ public:
+  explicit GstPylonWriteBatch(const std::vector<GenApi::INode *> &features) {
+    for (const auto &feature : features) {
+      for (const auto &influencer :
+           gst_pylon_find_influencing_features(feature)) {
+        if (influencer != feature) {
+          dependents[influencer].push_back(feature);
+        }
+      }
+    }
+  }
+
+  /* The feature was read and holds the value of the action */
+  void read(GstPylonActions *action) { known[action->get_node()] = action; }
+
+  void write(GstPylonActions *action, gboolean best_effort = FALSE) {
+    GenApi::INode *node = action->get_node();
+
+    pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                 [node](const GstPylonPendingWrite &w) {
+                                   return w.action->get_node() == node;
+                                 }),
+                  pending.end());
+    pending.push_back({action, best_effort});
+  }
+
+  /* Throws if a write that is not best effort fails. Every write queued
+   * after it is dropped. */
+  void flush() {
+    std::vector<GstPylonPendingWrite> writes;
+    writes.swap(pending);
+
+    for (const auto &w : writes) {
+      GenApi::INode *node = w.action->get_node();
+      auto current = known.find(node);
+
+      if (current != known.end() && w.action->has_value_of(current->second)) {
+        skipped++;
+        continue;
+      }
+
+      issued++;
+      written.insert(node);
+      forget_dependents(node);
+      try {
+        w.action->set_value();
+        known[node] = w.action;
+      } catch (const Pylon::GenericException &) {
+        known.erase(node);
+        if (!w.best_effort) {
+          throw;
+        }
+      }
+    }
+  }
+
+  /* Returns the features written since the last call */
+  std::set<GenApi::INode *> take_written() {
+    std::set<GenApi::INode *> features;
+    features.swap(written);
+    return features;
+  }
+
+  guint get_issued() const { return issued; }
+  guint get_skipped() const { return skipped; }
+
+ private:
+  struct GstPylonPendingWrite {
+    GstPylonActions *action;
+    gboolean best_effort;
+  };
+
+  void forget_dependents(GenApi::INode *node) {
+    auto deps = dependents.find(node);
+    if (deps == dependents.end()) {
+      return;
+    }
+    for (const auto &dep : deps->second) {
+      known.erase(dep);
+    }
+  }
+
+  std::vector<GstPylonPendingWrite> pending;
+  std::unordered_map<GenApi::INode *, GstPylonActions *> known;
+  std::unordered_map<GenApi::INode *, std::vector<GenApi::INode *>>
+      dependents;
+  std::set<GenApi::INode *> written;
+  guint issued = 0;
+  guint skipped = 0;
+};
 
 static gboolean gst_pylon_can_feature_later_be_writable(GenApi::INode *node) {
   GenICam::gcstring value;
@@ -146,37 +274,51 @@ static gboolean gst_pylon_can_feature_later_be_writable(GenApi::INode *node) {
   }
 }
 
-static GParamFlags gst_pylon_query_access(GenApi::INodeMap &nodemap,
-                                          GenApi::INode *node) {
+/* Queries the access flags that don't depend on the transport layer
+ * parameters being locked. check_mutability is set if the feature is
+ * writable now and it remains to check whether it stays writable in PLAYING
+ * state. */
+static GParamFlags gst_pylon_query_static_access(GenApi::INode *node,
+                                                 gboolean &check_mutability) {
   gint flags = 0;
 
+  check_mutability = FALSE;
+
   g_return_val_if_fail(node, static_cast<GParamFlags>(flags));
 
   Pylon::CParameter param(node);
-  gboolean is_writable = FALSE;
 
   if (param.IsReadable()) {
     flags |= G_PARAM_READABLE;
   }
   if (param.IsWritable()) {
     flags |= G_PARAM_WRITABLE;
-    is_writable = TRUE;
+    check_mutability = TRUE;
   }
   if (!param.IsWritable() && gst_pylon_can_feature_later_be_writable(node)) {
     flags |= G_PARAM_WRITABLE;
   }
 
-  gboolean is_read_write = param.IsReadable() && param.IsWritable();
-  gboolean is_write_only = !param.IsReadable() && param.IsWritable();
+  return static_cast<GParamFlags>(flags);
+}
+
+static GParamFlags gst_pylon_query_access(GenApi::INodeMap &nodemap,
+                                          GenApi::INode *node) {
+  gboolean check_mutability = FALSE;
+
+  g_return_val_if_fail(node, static_cast<GParamFlags>(0));
+
+  gint flags = gst_pylon_query_static_access(node, check_mutability);
 
   /* Check if feature is writable in PLAYING state */
-  if (is_read_write || is_write_only) {
+  if (check_mutability) {
+    Pylon::CParameter param(node);
     Pylon::CIntegerParameter tl_params_locked(nodemap, "TLParamsLocked");
     if (tl_params_locked.IsValid()) {
       /* Check if feature is writable at runtime by checking if it is still
        * writable after setting TLParamsLocked to 1. */
       tl_params_locked.SetValue(1);
-      if (is_writable && param.IsWritable()) {
+      if (param.IsWritable()) {
         flags |= GST_PARAM_MUTABLE_PLAYING;
       } else {
         flags |= GST_PARAM_MUTABLE_READY;
@@ -262,22 +404,83 @@ static std::vector<GenApi::INode *> gst_pylon_get_available_features(
   return available_features;
 }
 
-template <class Type>
-static std::vector<std::vector<Type>> gst_pylon_cartesian_product(
-    std::vector<std::vector<Type>> &values) {
-  std::vector<std::vector<Type>> result;
-  auto product = [](long long a, std::vector<Type> &b) { return a * b.size(); };
-  const long long N = accumulate(values.begin(), values.end(), 1LL, product);
-  std::vector<Type> result_combination(values.size());
-  for (long long n = 0; n < N; ++n) {
-    lldiv_t div_result{n, 0};
-    for (long long i = values.size() - 1; 0 <= i; --i) {
-      div_result = div(div_result.quot, values[i].size());
-      result_combination[i] = values[i][div_result.rem];
+static std::set<GenApi::INode *> gst_pylon_find_influencing_features(
+    GenApi::INode *node) {
+  std::set<GenApi::INode *> features;
+
+  g_return_val_if_fail(node, features);
+
+  return gst_pylon_find_influencing_features(
+      node, {node, gst_pylon_find_limit_node(node, "pMin"),
+             gst_pylon_find_limit_node(node, "pMax")});
+}
+
+/* Features whose changes invalidate any of the candidate nodes */
+static std::set<GenApi::INode *> gst_pylon_find_influencing_features(
+    GenApi::INode *node, const std::vector<GenApi::INode *> &candidates) {
+  std::unordered_map<std::string, GenApi::INode *> invalidators;
+  std::set<GenApi::INode *> features;
+  GenICam::gcstring value;
+  GenICam::gcstring attribute;
+
+  g_return_val_if_fail(node, features);
+
+  for (const auto &candidate : candidates) {
+    if (candidate && candidate->GetProperty("pInvalidator", value, attribute)) {
+      gst_pylon_add_all_property_values(node, std::string(value),
+                                        invalidators);
+    }
+  }
+
+  for (const auto &inv : invalidators) {
+    if (!inv.second) {
+      continue;
+    }
+    std::vector<GenApi::INode *> parent_features =
+        gst_pylon_find_parent_features(inv.second);
+    features.insert(parent_features.begin(), parent_features.end());
+  }
+
+  return features;
+}
+
+static std::vector<std::vector<gsize>> gst_pylon_group_features(
+    const std::vector<GenApi::INode *> &features) {
+  std::vector<gsize> parent(features.size());
+  std::map<gsize, std::vector<gsize>> groups;
+  std::vector<std::vector<gsize>> components;
+
+  std::iota(parent.begin(), parent.end(), 0);
+
+  auto find_root = [&parent](gsize i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
     }
-    result.push_back(result_combination);
+    return i;
+  };
+
+  /* Features end up in the same component if one of them changes the
+   * behaviour of the other */
+  for (gsize i = 0; i < features.size(); i++) {
+    std::set<GenApi::INode *> influencers =
+        gst_pylon_find_influencing_features(features[i]);
+    for (gsize j = 0; j < features.size(); j++) {
+      if (i != j && influencers.count(features[j])) {
+        parent[find_root(i)] = find_root(j);
+      }
+    }
+  }
+
+  for (gsize i = 0; i < features.size(); i++) {
+    groups[find_root(i)].push_back(i);
   }
-  return result;
+
+  for (auto &group : groups) {
+    components.push_back(std::move(group.second));
+  }
+
+  return components;
 }
 
 template <class P, class T>
@@ -421,6 +624,188 @@ static std::vector<GstPylonActions *> gst_pylon_create_reset_value_actions(
   return actions_list;
 }
 
+/* Explores the limits of a feature under the settings of its invalidators.
+ * Each independent component of invalidators is walked depth first while
+ * the others keep their current value, so a failing write prunes every
+ * setting below it and shared prefixes are only written once. The best
+ * settings found per component are combined at the end. A limit is only
+ * read again if one of the features written since its last read
+ * invalidates it. */
+template <class P, class T>
+class GstPylonLimitExplorer {
+ public:
+  GstPylonLimitExplorer(
+      GenApi::INode *node,
+      const std::vector<std::vector<GstPylonActions *>> &actions_list,
+      const std::vector<GstPylonActions *> &reset_list,
+      GstPylonWriteBatch &batch)
+      : node(node),
+        actions_list(actions_list),
+        reset_list(reset_list),
+        batch(batch),
+        assignment(actions_list.size(), -1),
+        min_assignment(actions_list.size(), -1),
+        max_assignment(actions_list.size(), -1),
+        component(NULL),
+        min_influencers(gst_pylon_find_influencing_features(
+            node, {node, gst_pylon_find_limit_node(node, "pMin")})),
+        max_influencers(gst_pylon_find_influencing_features(
+            node, {node, gst_pylon_find_limit_node(node, "pMax")})),
+        minimum(gst_pylon_query_feature_limits<P, T>(node, "min")),
+        maximum(gst_pylon_query_feature_limits<P, T>(node, "max")),
+        last_limits(minimum, maximum),
+        last_limits_valid(TRUE) {
+    memo[assignment] = last_limits;
+  }
+
+  void explore_component(const std::vector<gsize> &slots) {
+    component = &slots;
+    explore_slot(0);
+    component = NULL;
+
+    restore(slots);
+  }
+
+  void explore_extremes() {
+    std::vector<gsize> all_slots(actions_list.size());
+    std::iota(all_slots.begin(), all_slots.end(), 0);
+
+    for (const auto &extreme : {min_assignment, max_assignment}) {
+      if (memo.find(extreme) != memo.end()) {
+        continue;
+      }
+      for (gsize slot = 0; slot < extreme.size(); slot++) {
+        if (extreme[slot] < 0) {
+          continue;
+        }
+        try {
+          batch.write(actions_list[slot][extreme[slot]]);
+          batch.flush();
+          assignment[slot] = extreme[slot];
+        } catch (const Pylon::GenericException &) {
+          continue;
+        }
+      }
+      observe();
+      restore(all_slots);
+    }
+  }
+
+  T get_minimum() const { return minimum; }
+  T get_maximum() const { return maximum; }
+
+ private:
+  void explore_slot(gsize depth) {
+    if (depth == component->size()) {
+      observe();
+      return;
+    }
+
+    gsize slot = component->at(depth);
+    gboolean applied = FALSE;
+
+    for (gsize i = 0; i < actions_list[slot].size(); i++) {
+      /* Some states might not be valid, skip every setting that builds on
+       * them */
+      try {
+        batch.write(actions_list[slot][i]);
+        batch.flush();
+      } catch (const Pylon::GenericException &) {
+        continue;
+      }
+      applied = TRUE;
+      assignment[slot] = static_cast<gint>(i);
+      explore_slot(depth + 1);
+    }
+
+    /* The feature can't be changed in this state, keep exploring the rest
+     * of the component with its current value */
+    if (!applied) {
+      explore_slot(depth + 1);
+    }
+  }
+
+  void observe() {
+    std::pair<T, T> limits;
+    auto cached = memo.find(assignment);
+
+    if (cached != memo.end()) {
+      limits = cached->second;
+    } else {
+      try {
+        batch.flush();
+        std::set<GenApi::INode *> written = batch.take_written();
+        if (!last_limits_valid || is_influenced(written, min_influencers)) {
+          last_limits.first = gst_pylon_query_feature_limits<P, T>(node, "min");
+        }
+        if (!last_limits_valid || is_influenced(written, max_influencers)) {
+          last_limits.second =
+              gst_pylon_query_feature_limits<P, T>(node, "max");
+        }
+        last_limits_valid = TRUE;
+      } catch (const Pylon::GenericException &) {
+        last_limits_valid = FALSE;
+        return;
+      }
+      limits = last_limits;
+      memo[assignment] = limits;
+    }
+
+    if (limits.first < minimum) {
+      minimum = limits.first;
+      save_assignment(min_assignment);
+    }
+    if (limits.second > maximum) {
+      maximum = limits.second;
+      save_assignment(max_assignment);
+    }
+  }
+
+  static gboolean is_influenced(const std::set<GenApi::INode *> &written,
+                                const std::set<GenApi::INode *> &influencers) {
+    for (const auto &feature : written) {
+      if (influencers.count(feature)) {
+        return TRUE;
+      }
+    }
+    return FALSE;
+  }
+
+  void save_assignment(std::vector<gint> &target) {
+    if (!component) {
+      return;
+    }
+    for (const auto &slot : *component) {
+      target[slot] = assignment[slot];
+    }
+  }
+
+  /* The resets are only queued, so they can be coalesced with the next
+   * writes to the same features */
+  void restore(const std::vector<gsize> &slots) {
+    for (const auto &slot : slots) {
+      batch.write(reset_list[slot], TRUE);
+      assignment[slot] = -1;
+    }
+  }
+
+  GenApi::INode *node;
+  const std::vector<std::vector<GstPylonActions *>> &actions_list;
+  const std::vector<GstPylonActions *> &reset_list;
+  GstPylonWriteBatch &batch;
+  std::vector<gint> assignment;
+  std::vector<gint> min_assignment;
+  std::vector<gint> max_assignment;
+  std::map<std::vector<gint>, std::pair<T, T>> memo;
+  const std::vector<gsize> *component;
+  std::set<GenApi::INode *> min_influencers;
+  std::set<GenApi::INode *> max_influencers;
+  T minimum;
+  T maximum;
+  std::pair<T, T> last_limits;
+  gboolean last_limits_valid;
+};
+
 template <class P, class T>
 static void gst_pylon_find_limits(GenApi::INode *node,
                                   T &minimum_under_all_settings,
@@ -466,43 +851,38 @@ static void gst_pylon_find_limits(GenApi::INode *node,
   /* Save current set of values */
   std::vector<GstPylonActions *> reset_list =
       gst_pylon_create_reset_value_actions(available_parent_inv);
+  GstPylonWriteBatch batch(available_parent_inv);
+  for (const auto &action : reset_list) {
+    batch.read(action);
+  }
 
   /* Create list of extreme value settings per invalidator */
   std::vector<std::vector<GstPylonActions *>> actions_list =
       gst_pylon_create_set_value_actions(available_parent_inv);
 
-  /* Create list of all possible setting permutations and execute them all */
-  auto action_list_permutations = gst_pylon_cartesian_product(actions_list);
-  std::vector<T> min_values;
-  std::vector<T> max_values;
-  for (const auto &actions : action_list_permutations) {
-    for (const auto &action : actions) {
-      /* Some states might not be valid, so just skip them */
-      try {
-        action->set_value();
-      } catch (const Pylon::GenericException &) {
-        continue;
-      }
-    }
-    /* Capture min and max values after all setting are applied*/
-    min_values.push_back(gst_pylon_query_feature_limits<P, T>(node, "min"));
-    max_values.push_back(gst_pylon_query_feature_limits<P, T>(node, "max"));
+  /* Explore the invalidators in groups that don't influence each other
+   * instead of the full product of all their settings */
+  std::vector<std::vector<gsize>> components =
+      gst_pylon_group_features(available_parent_inv);
+  GstPylonLimitExplorer<P, T> explorer(node, actions_list, reset_list, batch);
+
+  for (const auto &component : components) {
+    explorer.explore_component(component);
   }
+  explorer.explore_extremes();
 
   /* Get the max and min values under all settings executed*/
-  minimum_under_all_settings =
-      *std::min_element(min_values.begin(), min_values.end());
-  maximum_under_all_settings =
-      *std::max_element(max_values.begin(), max_values.end());
+  minimum_under_all_settings = explorer.get_minimum();
+  maximum_under_all_settings = explorer.get_maximum();
 
   /* Reset to old values */
   for (const auto &action : reset_list) {
-    try {
-      action->set_value();
-    } catch (const Pylon::GenericException &) {
-      continue;
-    }
+    batch.write(action, TRUE);
   }
+  batch.flush();
+
+  GST_LOG("Explored limits of \"%s\" with %u writes, %u skipped",
+          node->GetName().c_str(), batch.get_issued(), batch.get_skipped());
 
   /* Clean up */
   for (const auto &actions : actions_list) {
@@ -515,26 +895,97 @@ static void gst_pylon_find_limits(GenApi::INode *node,
   }
 }
 
+static GParamFlags gst_pylon_get_access(GenApi::INodeMap &nodemap,
+                                        GenApi::INode *node,
+                                        GstPylonCache &cache) {
+  GParamFlags flags = static_cast<GParamFlags>(0);
+
+  g_return_val_if_fail(node, flags);
+
+  if (!cache.get_flags(node->GetName(), flags)) {
+    flags = gst_pylon_query_access(nodemap, node);
+    cache.set_flags(node->GetName(), flags);
+  }
+
+  return flags;
+}
+
+/* Exploring the limits under all settings is expensive, so unless they are
+ * cached the full range of the type is installed. The exact limits are
+ * explored per object on the first write. Returns TRUE if the limits are
+ * exact. */
+static gboolean gst_pylon_get_int64_limits(GenApi::INode *node,
+                                           gint64 &min_value, gint64 &max_value,
+                                           GstPylonCache &cache) {
+  g_return_val_if_fail(node, FALSE);
+
+  if (cache.get_int_limits(node->GetName(), min_value, max_value)) {
+    return TRUE;
+  }
+
+  min_value = G_MININT64;
+  max_value = G_MAXINT64;
+
+  return FALSE;
+}
+
+static gboolean gst_pylon_get_float_limits(GenApi::INode *node,
+                                           gdouble &min_value,
+                                           gdouble &max_value,
+                                           GstPylonCache &cache) {
+  g_return_val_if_fail(node, FALSE);
+
+  if (cache.get_double_limits(node->GetName(), min_value, max_value)) {
+    return TRUE;
+  }
+
+  min_value = -G_MAXFLOAT;
+  max_value = G_MAXFLOAT;
+
+  return FALSE;
+}
+
+static GQuark gst_pylon_param_spec_provisional_quark() {
+  static GQuark quark =
+      g_quark_from_static_string("GstPylonParamSpecProvisional");
+
+  return quark;
+}
+
+/* Only called before the spec is installed, the mark never changes */
+static GParamSpec *gst_pylon_param_spec_mark_provisional(GParamSpec *spec,
+                                                         gboolean exact) {
+  if (spec && !exact) {
+    g_param_spec_set_qdata(spec, gst_pylon_param_spec_provisional_quark(),
+                           GINT_TO_POINTER(TRUE));
+  }
+
+  return spec;
+}
+
 static GParamSpec *gst_pylon_make_spec_int64(GenApi::INodeMap &nodemap,
-                                             GenApi::INode *node) {
+                                             GenApi::INode *node,
+                                             GstPylonCache &cache) {
   g_return_val_if_fail(node, NULL);
 
   Pylon::CIntegerParameter param(node);
   gint64 max_value = 0;
   gint64 min_value = 0;
 
-  gst_pylon_find_limits<Pylon::CIntegerParameter, gint64>(node, min_value,
-                                                          max_value);
+  gboolean exact =
+      gst_pylon_get_int64_limits(node, min_value, max_value, cache);
 
-  return g_param_spec_int64(
-      node->GetName(), node->GetDisplayName(), node->GetToolTip(), min_value,
-      max_value, param.GetValue(), gst_pylon_query_access(nodemap, node));
+  return gst_pylon_param_spec_mark_provisional(
+      g_param_spec_int64(node->GetName(), node->GetDisplayName(),
+                         node->GetToolTip(), min_value, max_value,
+                         CLAMP(param.GetValue(), min_value, max_value),
+                         gst_pylon_get_access(nodemap, node, cache)),
+      exact);
 }
 
-static GParamSpec *gst_pylon_make_spec_selector_int64(GenApi::INodeMap &nodemap,
-                                                      GenApi::INode *node,
-                                                      GenApi::INode *selector,
-                                                      guint64 selector_value) {
+static GParamSpec *gst_pylon_make_spec_selector_int64(
+    GenApi::INodeMap &nodemap, GenApi::INode *node, GenApi::INode *selector,
+    guint64 selector_value, GstPylonCache &cache) {
   g_return_val_if_fail(node, NULL);
   g_return_val_if_fail(selector, NULL);
 
@@ -542,30 +993,33 @@ static GParamSpec *gst_pylon_make_spec_selector_int64(GenApi::INodeMap &nodemap,
   gint64 max_value = 0;
   gint64 min_value = 0;
 
-  gst_pylon_find_limits<Pylon::CIntegerParameter, gint64>(node, min_value,
-                                                          max_value);
+  gboolean exact =
+      gst_pylon_get_int64_limits(node, min_value, max_value, cache);
 
-  return gst_pylon_param_spec_selector_int64(
-      nodemap, node->GetName(), selector->GetName(), selector_value,
-      node->GetDisplayName(), node->GetToolTip(), min_value, max_value,
-      param.GetValue(), gst_pylon_query_access(nodemap, node));
+  return gst_pylon_param_spec_mark_provisional(
+      gst_pylon_param_spec_selector_int64(
+          nodemap, node->GetName(), selector->GetName(), selector_value,
+          node->GetDisplayName(), node->GetToolTip(), min_value, max_value,
+          CLAMP(param.GetValue(), min_value, max_value),
+          gst_pylon_get_access(nodemap, node, cache)),
+      exact);
 }
 
 static GParamSpec *gst_pylon_make_spec_bool(GenApi::INodeMap &nodemap,
-                                            GenApi::INode *node) {
+                                            GenApi::INode *node,
+                                            GstPylonCache &cache) {
   g_return_val_if_fail(node, NULL);
 
   Pylon::CBooleanParameter param(node);
 
   return g_param_spec_boolean(node->GetName(), node->GetDisplayName(),
                               node->GetToolTip(), param.GetValue(),
-                              gst_pylon_query_access(nodemap, node));
+                              gst_pylon_get_access(nodemap, node, cache));
 }
 
-static GParamSpec *gst_pylon_make_spec_selector_bool(GenApi::INodeMap &nodemap,
-                                                     GenApi::INode *node,
-                                                     GenApi::INode *selector,
-                                                     guint64 selector_value) {
+static GParamSpec *gst_pylon_make_spec_selector_bool(
+    GenApi::INodeMap &nodemap, GenApi::INode *node, GenApi::INode *selector,
+    guint64 selector_value, GstPylonCache &cache) {
   g_return_val_if_fail(node, NULL);
   g_return_val_if_fail(selector, NULL);
 
@@ -574,29 +1028,32 @@ static GParamSpec *gst_pylon_make_spec_selector_bool(GenApi::INodeMap &nodemap,
   return gst_pylon_param_spec_selector_boolean(
       nodemap, node->GetName(), selector->GetName(), selector_value,
       node->GetDisplayName(), node->GetToolTip(), param.GetValue(),
-      gst_pylon_query_access(nodemap, node));
+      gst_pylon_get_access(nodemap, node, cache));
 }
 
 static GParamSpec *gst_pylon_make_spec_float(GenApi::INodeMap &nodemap,
-                                             GenApi::INode *node) {
+                                             GenApi::INode *node,
+                                             GstPylonCache &cache) {
   g_return_val_if_fail(node, NULL);
 
   Pylon::CFloatParameter param(node);
   gdouble max_value = 0;
   gdouble min_value = 0;
 
-  gst_pylon_find_limits<Pylon::CFloatParameter, gdouble>(node, min_value,
-                                                         max_value);
+  gboolean exact =
+      gst_pylon_get_float_limits(node, min_value, max_value, cache);
 
-  return g_param_spec_float(
-      node->GetName(), node->GetDisplayName(), node->GetToolTip(), min_value,
-      max_value, param.GetValue(), gst_pylon_query_access(nodemap, node));
+  return gst_pylon_param_spec_mark_provisional(
+      g_param_spec_float(node->GetName(), node->GetDisplayName(),
+                         node->GetToolTip(), min_value, max_value,
+                         CLAMP(param.GetValue(), min_value, max_value),
+                         gst_pylon_get_access(nodemap, node, cache)),
+      exact);
 }
 
-static GParamSpec *gst_pylon_make_spec_selector_float(GenApi::INodeMap &nodemap,
-                                                      GenApi::INode *node,
-                                                      GenApi::INode *selector,
-                                                      guint64 selector_value) {
+static GParamSpec *gst_pylon_make_spec_selector_float(
+    GenApi::INodeMap &nodemap, GenApi::INode *node, GenApi::INode *selector,
+    guint64 selector_value, GstPylonCache &cache) {
   g_return_val_if_fail(node, NULL);
   g_return_val_if_fail(selector, NULL);
 
@@ -604,30 +1061,33 @@ static GParamSpec *gst_pylon_make_spec_selector_float(GenApi::INodeMap &nodemap,
   gdouble max_value = 0;
   gdouble min_value = 0;
 
-  gst_pylon_find_limits<Pylon::CFloatParameter, gdouble>(node, min_value,
-                                                         max_value);
+  gboolean exact =
+      gst_pylon_get_float_limits(node, min_value, max_value, cache);
 
-  return gst_pylon_param_spec_selector_float(
-      nodemap, node->GetName(), selector->GetName(), selector_value,
-      node->GetDisplayName(), node->GetToolTip(), min_value, max_value,
-      param.GetValue(), gst_pylon_query_access(nodemap, node));
+  return gst_pylon_param_spec_mark_provisional(
+      gst_pylon_param_spec_selector_float(
+          nodemap, node->GetName(), selector->GetName(), selector_value,
+          node->GetDisplayName(), node->GetToolTip(), min_value, max_value,
+          CLAMP(param.GetValue(), min_value, max_value),
+          gst_pylon_get_access(nodemap, node, cache)),
+      exact);
 }
 
 static GParamSpec *gst_pylon_make_spec_str(GenApi::INodeMap &nodemap,
-                                           GenApi::INode *node) {
+                                           GenApi::INode *node,
+                                           GstPylonCache &cache) {
   g_return_val_if_fail(node, NULL);
 
   Pylon::CStringParameter param(node);
 
   return g_param_spec_string(node->GetName(), node->GetDisplayName(),
                              node->GetToolTip(), param.GetValue(),
-                             gst_pylon_query_access(nodemap, node));
+                             gst_pylon_get_access(nodemap, node, cache));
 }
 
-static GParamSpec *gst_pylon_make_spec_selector_str(GenApi::INodeMap &nodemap,
-                                                    GenApi::INode *node,
-                                                    GenApi::INode *selector,
-                                                    guint64 selector_value) {
+static GParamSpec *gst_pylon_make_spec_selector_str(
+    GenApi::INodeMap &nodemap, GenApi::INode *node, GenApi::INode *selector,
+    guint64 selector_value, GstPylonCache &cache) {
   g_return_val_if_fail(node, NULL);
   g_return_val_if_fail(selector, NULL);
 
@@ -636,17 +1096,20 @@ static GParamSpec *gst_pylon_make_spec_selector_str(GenApi::INodeMap &nodemap,
   return gst_pylon_param_spec_selector_string(
       nodemap, node->GetName(), selector->GetName(), selector_value,
       node->GetDisplayName(), node->GetToolTip(), param.GetValue(),
-      gst_pylon_query_access(nodemap, node));
+      gst_pylon_get_access(nodemap, node, cache));
 }
 
 static GType gst_pylon_make_enum_type(GenApi::INodeMap &nodemap,
                                       GenApi::INode *node,
-                                      const gchar *device_fullname) {
+                                      const gchar *device_fullname,
+                                      GstPylonCache &cache) {
   /* When registering enums to the GType system, their string pointers
      must remain valid throughout the application lifespan. To achieve this
      we are saving all found enums into a static hash table
   */
   static std::unordered_map<GType, std::vector<GEnumValue>> persistent_values;
+  /* Devices may be introspected from multiple threads */
+  static std::mutex persistent_values_mutex;
 
   g_return_val_if_fail(node, G_TYPE_INVALID);
 
@@ -661,24 +1124,34 @@ static GType gst_pylon_make_enum_type(GenApi::INodeMap &nodemap,
 
   if (!type) {
     std::vector<GEnumValue> enumvalues;
-    GenApi::StringList_t values;
+    std::vector<GstPylonCacheEnumEntry> entries;
 
-    param.GetSettableValues(values);
-    for (const auto &value_name : values) {
-      auto entry = param.GetEntryByName(value_name);
-      auto value = static_cast<gint>(entry->GetValue());
-      auto tooltip = entry->GetNode()->GetToolTip();
+    if (!cache.get_enum_entries(node->GetName(), entries)) {
+      GenApi::StringList_t values;
 
+      param.GetSettableValues(values);
+      for (const auto &value_name : values) {
+        auto entry = param.GetEntryByName(value_name);
+        auto value = static_cast<gint>(entry->GetValue());
+        auto tooltip = entry->GetNode()->GetToolTip();
+
+        entries.push_back({value, value_name.c_str(), tooltip.c_str()});
+      }
+      cache.set_enum_entries(node->GetName(), entries);
+    }
+
+    for (const auto &entry : entries) {
       /* We need a copy of the strings so that they are persistent
          throughout the application lifespan */
-      GEnumValue ev = {value, g_strdup(value_name.c_str()),
-                       g_strdup(tooltip.c_str())};
+      GEnumValue ev = {entry.value, g_strdup(entry.name.c_str()),
+                       g_strdup(entry.tooltip.c_str())};
       enumvalues.push_back(ev);
     }
 
     GEnumValue sentinel = {0};
     enumvalues.push_back(sentinel);
 
+    std::lock_guard<std::mutex> lock(persistent_values_mutex);
     type = g_enum_register_static(name, enumvalues.data());
     persistent_values.insert({type, std::move(enumvalues)});
   }
@@ -690,37 +1163,40 @@ static GType gst_pylon_make_enum_type(GenApi::INodeMap &nodemap,
 
 static GParamSpec *gst_pylon_make_spec_enum(GenApi::INodeMap &nodemap,
                                             GenApi::INode *node,
-                                            const gchar *device_fullname) {
+                                            const gchar *device_fullname,
+                                            GstPylonCache &cache) {
   g_return_val_if_fail(node, NULL);
 
   Pylon::CEnumParameter param(node);
-  GType type = gst_pylon_make_enum_type(nodemap, node, device_fullname);
+  GType type = gst_pylon_make_enum_type(nodemap, node, device_fullname, cache);
 
   return g_param_spec_enum(node->GetName(), node->GetDisplayName(),
                            node->GetToolTip(), type, param.GetIntValue(),
-                           gst_pylon_query_access(nodemap, node));
+                           gst_pylon_get_access(nodemap, node, cache));
 }
 
 static GParamSpec *gst_pylon_make_spec_selector_enum(
     GenApi::INodeMap &nodemap, GenApi::INode *node, GenApi::INode *selector,
-    guint64 selector_value, const gchar *device_fullname) {
+    guint64 selector_value, const gchar *device_fullname,
+    GstPylonCache &cache) {
   g_return_val_if_fail(node, NULL);
   g_return_val_if_fail(selector, NULL);
 
   Pylon::CEnumParameter param(node);
-  GType type = gst_pylon_make_enum_type(nodemap, node, device_fullname);
+  GType type = gst_pylon_make_enum_type(nodemap, node, device_fullname, cache);
 
   return gst_pylon_param_spec_selector_enum(
       nodemap, node->GetName(), selector->GetName(), selector_value,
       node->GetDisplayName(), node->GetToolTip(), type, param.GetIntValue(),
-      gst_pylon_query_access(nodemap, node), device_fullname);
+      gst_pylon_get_access(nodemap, node, cache), device_fullname);
 }
 
 GParamSpec *GstPylonParamFactory::make_param(GenApi::INodeMap &nodemap,
                                              GenApi::INode *node,
                                              GenApi::INode *selector,
                                              guint64 selector_value,
-                                             const gchar *device_fullname) {
+                                             const gchar *device_fullname,
+                                             GstPylonCache &cache) {
   g_return_val_if_fail(node, NULL);
 
   GParamSpec *spec = NULL;
@@ -729,42 +1205,42 @@ GParamSpec *GstPylonParamFactory::make_param(GenApi::INodeMap &nodemap,
   switch (iface) {
     case GenApi::intfIInteger:
       if (!selector) {
-        spec = gst_pylon_make_spec_int64(nodemap, node);
+        spec = gst_pylon_make_spec_int64(nodemap, node, cache);
       } else {
         spec = gst_pylon_make_spec_selector_int64(nodemap, node, selector,
-                                                  selector_value);
+                                                  selector_value, cache);
       }
       break;
     case GenApi::intfIBoolean:
       if (!selector) {
-        spec = gst_pylon_make_spec_bool(nodemap, node);
+        spec = gst_pylon_make_spec_bool(nodemap, node, cache);
       } else {
         spec = gst_pylon_make_spec_selector_bool(nodemap, node, selector,
-                                                 selector_value);
+                                                 selector_value, cache);
       }
       break;
     case GenApi::intfIFloat:
       if (!selector) {
-        spec = gst_pylon_make_spec_float(nodemap, node);
+        spec = gst_pylon_make_spec_float(nodemap, node, cache);
       } else {
         spec = gst_pylon_make_spec_selector_float(nodemap, node, selector,
-                                                  selector_value);
+                                                  selector_value, cache);
       }
       break;
     case GenApi::intfIString:
       if (!selector) {
-        spec = gst_pylon_make_spec_str(nodemap, node);
+        spec = gst_pylon_make_spec_str(nodemap, node, cache);
       } else {
         spec = gst_pylon_make_spec_selector_str(nodemap, node, selector,
-                                                selector_value);
+                                                selector_value, cache);
       }
       break;
     case GenApi::intfIEnumeration:
       if (!selector) {
-        spec = gst_pylon_make_spec_enum(nodemap, node, device_fullname);
+        spec = gst_pylon_make_spec_enum(nodemap, node, device_fullname, cache);
       } else {
         spec = gst_pylon_make_spec_selector_enum(
-            nodemap, node, selector, selector_value, device_fullname);
+            nodemap, node, selector, selector_value, device_fullname, cache);
       }
       break;
     default:
@@ -775,3 +1251,85 @@ GParamSpec *GstPylonParamFactory::make_param(GenApi::INodeMap &nodemap,
 
   return spec;
 }
+
+void GstPylonParamFactory::prefetch_access(
+    GenApi::INodeMap &nodemap, const std::vector<GenApi::INode *> &nodes,
+    GstPylonCache &cache) {
+  std::vector<std::pair<GenApi::INode *, GParamFlags>> mutable_candidates;
+  GParamFlags flags = static_cast<GParamFlags>(0);
+
+  for (const auto &node : nodes) {
+    gboolean check_mutability = FALSE;
+
+    if (cache.get_flags(node->GetName(), flags)) {
+      continue;
+    }
+
+    flags = gst_pylon_query_static_access(node, check_mutability);
+    if (check_mutability) {
+      mutable_candidates.push_back({node, flags});
+    } else {
+      cache.set_flags(node->GetName(), flags);
+    }
+  }
+
+  if (mutable_candidates.empty()) {
+    return;
+  }
+
+  /* Lock the transport layer parameters once for all features instead of
+   * toggling TLParamsLocked for each one of them */
+  Pylon::CIntegerParameter tl_params_locked(nodemap, "TLParamsLocked");
+  gboolean locked = tl_params_locked.IsValid();
+  if (locked) {
+    tl_params_locked.SetValue(1);
+  }
+
+  try {
+    for (const auto &candidate : mutable_candidates) {
+      gint candidate_flags = candidate.second;
+
+      if (locked && Pylon::CParameter(candidate.first).IsWritable()) {
+        candidate_flags |= GST_PARAM_MUTABLE_PLAYING;
+      } else {
+        candidate_flags |= GST_PARAM_MUTABLE_READY;
+      }
+      cache.set_flags(candidate.first->GetName(),
+                      static_cast<GParamFlags>(candidate_flags));
+    }
+  } catch (const Pylon::GenericException &) {
+    if (locked) {
+      tl_params_locked.SetValue(0);
+    }
+    throw;
+  }
+
+  if (locked) {
+    tl_params_locked.SetValue(0);
+  }
+}
+
+gboolean GstPylonParamFactory::is_provisional(GParamSpec *spec) {
+  g_return_val_if_fail(spec, FALSE);
+
+  return NULL !=
+         g_param_spec_get_qdata(spec, gst_pylon_param_spec_provisional_quark());
+}
+
+void GstPylonParamFactory::explore_limits(GenApi::INode *node,
+                                          gint64 &min_value,
+                                          gint64 &max_value) {
+  g_return_if_fail(node);
+
+  gst_pylon_find_limits<Pylon::CIntegerParameter, gint64>(node, min_value,
+                                                          max_value);
+}
+
+void GstPylonParamFactory::explore_limits(GenApi::INode *node,
+                                          gdouble &min_value,
+                                          gdouble &max_value) {
+  g_return_if_fail(node);
+
+  gst_pylon_find_limits<Pylon::CFloatParameter, gdouble>(node, min_value,
+                                                         max_value);
+}
@@ -33,6 +33,8 @@
 #ifndef _GST_PYLON_INTROSPECTION_H_
 #define _GST_PYLON_INTROSPECTION_H_
 
+#include "gstpyloncache.h"
+
 #include <gst/gst.h>
 
 #ifdef _MSC_VER  // MSVC
@@ -58,7 +60,20 @@ class GstPylonParamFactory {
  public:
   static GParamSpec *make_param(GenApi::INodeMap &nodemap, GenApi::INode *node,
                                 GenApi::INode *selector, guint64 selector_value,
-                                const gchar *device_fullname);
+                                const gchar *device_fullname,
+                                GstPylonCache &cache);
+  static void prefetch_access(GenApi::INodeMap &nodemap,
+                              const std::vector<GenApi::INode *> &nodes,
+                              GstPylonCache &cache);
+  /* Specs of numeric features whose limits were not cached are installed
+   * with the full range of their type */
+  static gboolean is_provisional(GParamSpec *spec);
+  /* Explores the limits of a feature under all the settings that influence
+   * them */
+  static void explore_limits(GenApi::INode *node, gint64 &min_value,
+                             gint64 &max_value);
+  static void explore_limits(GenApi::INode *node, gdouble &min_value,
+                             gdouble &max_value);
 };
 
 #endif
@@ -58,17 +58,71 @@
 #pragma GCC diagnostic pop
 #endif
 
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/* A chunk value to extract from every grab result, resolved once per chunk
+ * nodemap */
+typedef struct _GstPylonChunkEntry GstPylonChunkEntry;
+struct _GstPylonChunkEntry {
+  GenApi::INode *node;
+  GenApi::EInterfaceType iface;
+  GenApi::INode *selector_node;
+  int64_t selector_value;
+  GQuark field;
+};
+
+/* Pylon keeps one chunk nodemap per grab buffer, each one gets resolved the
+ * first time a grab result using it is seen. The generation counter is
+ * bumped from whatever thread changes the chunk configuration. Chunks may be
+ * decoded from the streaming thread or, when decoding lazily, from any
+ * consumer, so the nodemaps are guarded by the mutex. Lazily decoded metas
+ * may outlive the camera and hold a reference to the cache. */
+struct _GstPylonChunkCache {
+  std::atomic<gint> refcount;
+  std::mutex mutex;
+  std::atomic<guint> generation;
+  guint nodemaps_generation;
+  std::unordered_map<GenApi::INodeMap *, std::vector<GstPylonChunkEntry>>
+      nodemaps;
+  std::vector<std::pair<GenApi::INode *, GenApi::CallbackHandleType>>
+      callbacks;
+
+  void OnChunkConfigurationChanged(GenApi::INode *node) {
+    this->generation.fetch_add(1);
+  }
+};
+
 /* prototypes */
 static gboolean gst_pylon_meta_init(GstMeta *meta, gpointer params,
                                     GstBuffer *buffer);
 static void gst_pylon_meta_free(GstMeta *meta, GstBuffer *buffer);
-static void gst_pylon_meta_add_chunk_as_meta(GstStructure *st,
-                                             GenApi::INode *node,
-                                             GenApi::INode *selector_node,
-                                             const guint64 &selector_value);
+static void gst_pylon_meta_reset(GstPylonMeta *self);
+static gboolean gst_pylon_meta_transform(GstBuffer *transbuf, GstMeta *meta,
+                                         GstBuffer *buffer, GQuark type,
+                                         gpointer data);
+static void gst_pylon_meta_resolve_chunks(
+    GenApi::INodeMap &chunk_nodemap,
+    std::vector<GstPylonChunkEntry> &entries);
+static void gst_pylon_meta_read_chunk(GstPylonChunk *chunk,
+                                      const GstPylonChunkEntry &entry);
 static void gst_pylon_meta_fill_result_chunks(
     GstPylonMeta *self,
-    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr);
+    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr,
+    GstPylonChunkCache *cache);
+static void gst_pylon_meta_ensure_chunks(const GstPylonMeta *self);
+
+/* Grab result kept by a meta until its chunks are decoded */
+typedef struct _GstPylonLazyChunks GstPylonLazyChunks;
+struct _GstPylonLazyChunks {
+  gsize decoded;
+  Pylon::CBaslerUniversalGrabResultPtr grab_result;
+  GstPylonChunkCache *cache;
+};
 
 GType gst_pylon_meta_api_get_type(void) {
   static GType type = 0;
@@ -87,85 +141,79 @@ const GstMetaInfo *gst_pylon_meta_get_info(void) {
   if (g_once_init_enter(&info)) {
     const GstMetaInfo *meta = gst_meta_register(
         GST_PYLON_META_API_TYPE, "GstPylonMeta", sizeof(GstPylonMeta),
-        gst_pylon_meta_init, gst_pylon_meta_free, NULL);
+        gst_pylon_meta_init, gst_pylon_meta_free, gst_pylon_meta_transform);
     g_once_init_leave(&info, meta);
   }
   return info;
 }
 
-static void gst_pylon_meta_add_chunk_as_meta(GstStructure *st,
-                                             GenApi::INode *node,
-                                             GenApi::INode *selector_node,
-                                             const guint64 &selector_value) {
-  g_return_if_fail(st);
-  g_return_if_fail(node);
+GstPylonChunkCache *gst_pylon_chunk_cache_new(GenApi::INodeMap &nodemap) {
+  GstPylonChunkCache *cache = new GstPylonChunkCache;
+  static const gchar *chunk_configuration[] = {"ChunkModeActive",
+                                               "ChunkEnable"};
 
-  GValue value = G_VALUE_INIT;
-  gboolean is_valid = TRUE;
-  gchar *name = NULL;
+  cache->refcount = 1;
+  cache->generation = 0;
+  cache->nodemaps_generation = 0;
 
-  if (selector_node) {
-    Pylon::CEnumParameter selparam(selector_node);
-    selparam.SetIntValue(selector_value);
-    name = g_strdup_printf(
-        "%s-%s", node->GetName().c_str(),
-        selparam.GetEntry(selector_value)->GetSymbolic().c_str());
-  } else {
-    name = g_strdup(node->GetName().c_str());
+  /* The set of chunks in a grab result only changes when chunks are
+   * (de)activated */
+  for (const gchar *name : chunk_configuration) {
+    GenApi::INode *node = nodemap.GetNode(name);
+    if (!node) {
+      continue;
+    }
+
+    GenApi::CallbackHandleType handle = GenApi::Register(
+        node, *cache, &GstPylonChunkCache::OnChunkConfigurationChanged);
+    cache->callbacks.push_back(std::make_pair(node, handle));
   }
 
-  GenApi::EInterfaceType iface = node->GetPrincipalInterfaceType();
-  switch (iface) {
-    case GenApi::intfIInteger:
-      g_value_init(&value, G_TYPE_INT64);
-      g_value_set_int64(&value, Pylon::CIntegerParameter(node).GetValue());
-      break;
-    case GenApi::intfIBoolean:
-      g_value_init(&value, G_TYPE_BOOLEAN);
-      g_value_set_boolean(&value, Pylon::CBooleanParameter(node).GetValue());
-      break;
-    case GenApi::intfIFloat:
-      g_value_init(&value, G_TYPE_DOUBLE);
-      g_value_set_double(&value, Pylon::CFloatParameter(node).GetValue());
-      break;
-    case GenApi::intfIString:
-      g_value_init(&value, G_TYPE_STRING);
-      g_value_set_string(&value, Pylon::CStringParameter(node).GetValue());
-      break;
-    case GenApi::intfIEnumeration:
-      g_value_init(&value, G_TYPE_STRING);
-      g_value_set_string(&value,
-                         Pylon::CEnumParameter(node).GetValue().c_str());
-      break;
-    default:
-      is_valid = FALSE;
-      GST_WARNING("Chunk %s not added. Chunk of type %d is not supported", name,
-                  node->GetPrincipalInterfaceType());
-      break;
+  return cache;
+}
+
+static GstPylonChunkCache *gst_pylon_chunk_cache_ref(
+    GstPylonChunkCache *cache) {
+  cache->refcount.fetch_add(1);
+
+  return cache;
+}
+
+static void gst_pylon_chunk_cache_unref(GstPylonChunkCache *cache) {
+  if (1 == cache->refcount.fetch_sub(1)) {
+    delete cache;
   }
+}
+
+void gst_pylon_chunk_cache_free(GstPylonChunkCache *cache) {
+  g_return_if_fail(cache);
 
-  if (is_valid) {
-    gst_structure_set_value(st, name, &value);
+  /* The camera nodemap goes away with the camera, metas still holding the
+   * cache only need the chunk nodemaps of their own grab results */
+  for (auto &callback : cache->callbacks) {
+    callback.first->DeregisterCallback(callback.second);
   }
+  cache->callbacks.clear();
 
-  g_value_unset(&value);
-  g_free(name);
+  gst_pylon_chunk_cache_unref(cache);
 }
 
-static void gst_pylon_meta_fill_result_chunks(
-    GstPylonMeta *self,
-    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr) {
-  g_return_if_fail(self);
+void gst_pylon_chunk_cache_invalidate(GstPylonChunkCache *cache) {
+  g_return_if_fail(cache);
 
-  GstStructure *st = self->chunks;
+  cache->generation.fetch_add(1);
+}
 
-  GenApi::INodeMap &chunk_nodemap = grab_result_ptr->GetChunkDataNodeMap();
+static void gst_pylon_meta_resolve_chunks(
+    GenApi::INodeMap &chunk_nodemap,
+    std::vector<GstPylonChunkEntry> &entries) {
   GenApi::NodeList_t chunk_nodes;
   chunk_nodemap.GetNodes(chunk_nodes);
 
+  entries.clear();
+
   for (auto &node : chunk_nodes) {
     GenApi::INode *selector_node = NULL;
-    guint64 selector_value = 0;
 
     /* Only take into account valid Chunk nodes */
     auto sel_node = dynamic_cast<GenApi::ISelector *>(node);
@@ -174,6 +222,20 @@ static void gst_pylon_meta_fill_result_chunks(
       continue;
     }
 
+    GenApi::EInterfaceType iface = node->GetPrincipalInterfaceType();
+    switch (iface) {
+      case GenApi::intfIInteger:
+      case GenApi::intfIBoolean:
+      case GenApi::intfIFloat:
+      case GenApi::intfIString:
+      case GenApi::intfIEnumeration:
+        break;
+      default:
+        GST_WARNING("Chunk %s not added. Chunk of type %d is not supported",
+                    node->GetName().c_str(), iface);
+        continue;
+    }
+
     std::vector<std::string> enum_values;
     try {
       enum_values = gst_pylon_process_selector_features(node, &selector_node);
@@ -183,8 +245,6 @@ static void gst_pylon_meta_fill_result_chunks(
       continue;
     }
 
-    Pylon::CEnumParameter param(selector_node);
-
     /* If the number of selector values (stored in enum_values) is 1, leave
      * selector_node NULL, hence treating the feature as a "direct" one. */
     if (1 == enum_values.size()) {
@@ -192,23 +252,148 @@ static void gst_pylon_meta_fill_result_chunks(
     }
 
     for (auto const &sel_pair : enum_values) {
-      if (param.IsValid()) {
-        selector_value = param.GetEntryByName(sel_pair.c_str())->GetValue();
+      GstPylonChunkEntry entry = {node, iface, selector_node, 0, 0};
+      std::string name = std::string(node->GetName());
+
+      if (selector_node) {
+        if (GenApi::intfIEnumeration ==
+            selector_node->GetPrincipalInterfaceType()) {
+          Pylon::CEnumParameter param(selector_node);
+          entry.selector_value =
+              param.GetEntryByName(sel_pair.c_str())->GetValue();
+        } else {
+          entry.selector_value = std::stoll(sel_pair);
+        }
+        name += "-" + sel_pair;
       }
-      gst_pylon_meta_add_chunk_as_meta(st, node, selector_node, selector_value);
+
+      entry.field = g_quark_from_string(name.c_str());
+      entries.push_back(entry);
+    }
+  }
+}
+
+static void gst_pylon_meta_read_chunk(GstPylonChunk *chunk,
+                                      const GstPylonChunkEntry &entry) {
+  g_return_if_fail(chunk);
+
+  GenApi::INode *node = entry.node;
+
+  if (entry.selector_node) {
+    if (GenApi::intfIEnumeration ==
+        entry.selector_node->GetPrincipalInterfaceType()) {
+      Pylon::CEnumParameter(entry.selector_node)
+          .SetIntValue(entry.selector_value);
+    } else {
+      Pylon::CIntegerParameter(entry.selector_node)
+          .SetValue(entry.selector_value);
+    }
+  }
+
+  chunk->name = entry.field;
+
+  switch (entry.iface) {
+    case GenApi::intfIInteger:
+      chunk->type = GST_PYLON_CHUNK_TYPE_INT64;
+      chunk->value.v_int64 = Pylon::CIntegerParameter(node).GetValue();
+      break;
+    case GenApi::intfIBoolean:
+      chunk->type = GST_PYLON_CHUNK_TYPE_BOOLEAN;
+      chunk->value.v_boolean = Pylon::CBooleanParameter(node).GetValue();
+      break;
+    case GenApi::intfIFloat:
+      chunk->type = GST_PYLON_CHUNK_TYPE_DOUBLE;
+      chunk->value.v_double = Pylon::CFloatParameter(node).GetValue();
+      break;
+    case GenApi::intfIString:
+      chunk->type = GST_PYLON_CHUNK_TYPE_STRING;
+      chunk->value.v_string =
+          g_strdup(Pylon::CStringParameter(node).GetValue().c_str());
+      break;
+    case GenApi::intfIEnumeration:
+      chunk->type = GST_PYLON_CHUNK_TYPE_STRING;
+      chunk->value.v_string =
+          g_strdup(Pylon::CEnumParameter(node).GetValue().c_str());
+      break;
+    default:
+      g_assert_not_reached();
+      break;
+  }
+}
+
+static void gst_pylon_meta_fill_result_chunks(
+    GstPylonMeta *self,
+    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr,
+    GstPylonChunkCache *cache) {
+  g_return_if_fail(self);
+  g_return_if_fail(cache);
+
+  std::lock_guard<std::mutex> lock(cache->mutex);
+
+  GenApi::INodeMap &chunk_nodemap = grab_result_ptr->GetChunkDataNodeMap();
+  guint generation = cache->generation.load();
+
+  /* Chunk nodemaps are released along with the grab buffers, so drop every
+   * resolved nodemap once the chunk configuration changed */
+  if (cache->nodemaps_generation != generation) {
+    cache->nodemaps.clear();
+    cache->nodemaps_generation = generation;
+  }
+
+  auto nodemap_cache = cache->nodemaps.find(&chunk_nodemap);
+  if (cache->nodemaps.end() == nodemap_cache) {
+    std::vector<GstPylonChunkEntry> entries;
+
+    GST_DEBUG("Resolving chunks of nodemap %p", &chunk_nodemap);
+    gst_pylon_meta_resolve_chunks(chunk_nodemap, entries);
+    nodemap_cache =
+        cache->nodemaps.emplace(&chunk_nodemap, std::move(entries)).first;
+  }
+
+  for (const auto &entry : nodemap_cache->second) {
+    if (self->n_chunk_values == GST_PYLON_META_MAX_CHUNKS) {
+      GST_DEBUG("Chunk %s not added, the meta holds at most %d chunks",
+                g_quark_to_string(entry.field), GST_PYLON_META_MAX_CHUNKS);
+      continue;
+    }
+
+    try {
+      gst_pylon_meta_read_chunk(&self->chunk_values[self->n_chunk_values],
+                                entry);
+      self->n_chunk_values++;
+    } catch (const Pylon::GenericException &e) {
+      GST_WARNING("Chunk %s not added: %s", g_quark_to_string(entry.field),
+                  e.GetDescription());
     }
   }
 }
 
 void gst_buffer_add_pylon_meta(
     GstBuffer *buffer,
-    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr) {
+    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr,
+    GstPylonChunkCache *cache, GstPylonChunkDecoding decoding) {
   g_return_if_fail(buffer != NULL);
+  g_return_if_fail(cache != NULL);
 
   GST_LOG("Adding Pylon chunk meta to buffer %p", buffer);
 
+  /* Pooled buffers come back with the meta of their previous image */
   GstPylonMeta *self =
-      (GstPylonMeta *)gst_buffer_add_meta(buffer, GST_PYLON_META_INFO, NULL);
+      (GstPylonMeta *)gst_buffer_get_meta(buffer, GST_PYLON_META_API_TYPE);
+  if (self) {
+    gst_pylon_meta_reset(self);
+  } else {
+    self =
+        (GstPylonMeta *)gst_buffer_add_meta(buffer, GST_PYLON_META_INFO, NULL);
+  }
+
+  /* A lazily decoded meta holds on to the grab result, it has to go away
+   * with the image so pylon can requeue the grab buffer */
+  if (GST_PYLON_CHUNK_DECODING_LAZY == decoding) {
+    GST_META_FLAG_UNSET(self, GST_META_FLAG_POOLED);
+  } else {
+    GST_META_FLAG_SET(self, GST_META_FLAG_POOLED);
+  }
 
   /* Add meta to GstPylonMeta */
   self->block_id = grab_result_ptr->GetImageNumber();
@@ -219,8 +404,57 @@ void gst_buffer_add_pylon_meta(
   self->timestamp = grab_result_ptr->GetTimeStamp();
   grab_result_ptr->GetStride(self->stride);
 
-  if (grab_result_ptr->IsChunkDataAvailable()) {
-    gst_pylon_meta_fill_result_chunks(self, grab_result_ptr);
+  if (!grab_result_ptr->IsChunkDataAvailable()) {
+    return;
+  }
+
+  switch (decoding) {
+    case GST_PYLON_CHUNK_DECODING_EAGER:
+      try {
+        gst_pylon_meta_fill_result_chunks(self, grab_result_ptr, cache);
+      } catch (const Pylon::GenericException &e) {
+        GST_WARNING("Unable to decode chunks: %s", e.GetDescription());
+      }
+      break;
+    case GST_PYLON_CHUNK_DECODING_LAZY: {
+      /* Keep the grab result, and with it the chunk payload, until a
+       * consumer asks for a chunk */
+      GstPylonLazyChunks *lazy =
+          static_cast<GstPylonLazyChunks *>(self->lazy_chunks);
+      if (!lazy) {
+        lazy = new GstPylonLazyChunks;
+        self->lazy_chunks = lazy;
+      }
+      lazy->decoded = 0;
+      lazy->grab_result = grab_result_ptr;
+      lazy->cache = gst_pylon_chunk_cache_ref(cache);
+      break;
+    }
+    case GST_PYLON_CHUNK_DECODING_OFF:
+    default:
+      break;
+  }
+}
+
+static void gst_pylon_meta_ensure_chunks(const GstPylonMeta *self) {
+  GstPylonLazyChunks *lazy =
+      static_cast<GstPylonLazyChunks *>(self->lazy_chunks);
+
+  if (!lazy || !lazy->cache) {
+    return;
+  }
+
+  if (g_once_init_enter(&lazy->decoded)) {
+    GST_LOG("Decoding chunks of meta %p", self);
+
+    try {
+      gst_pylon_meta_fill_result_chunks(const_cast<GstPylonMeta *>(self),
+                                        lazy->grab_result, lazy->cache);
+    } catch (const Pylon::GenericException &e) {
+      GST_WARNING("Unable to decode chunks: %s", e.GetDescription());
+    }
+
+    g_once_init_leave(&lazy->decoded, 1);
   }
 }
 
@@ -228,7 +462,9 @@ static gboolean gst_pylon_meta_init(GstMeta *meta, gpointer params,
                                     GstBuffer *buffer) {
   GstPylonMeta *pylon_meta = (GstPylonMeta *)meta;
 
-  pylon_meta->chunks = gst_structure_new_empty("meta/x-pylon");
+  pylon_meta->chunks = NULL;
+  pylon_meta->n_chunk_values = 0;
+  pylon_meta->lazy_chunks = NULL;
 
   return TRUE;
 }
@@ -236,5 +472,236 @@ static gboolean gst_pylon_meta_init(GstMeta *meta, gpointer params,
 static void gst_pylon_meta_free(GstMeta *meta, GstBuffer *buffer) {
   GstPylonMeta *pylon_meta = (GstPylonMeta *)meta;
 
-  gst_structure_free(pylon_meta->chunks);
+  gst_pylon_meta_reset(pylon_meta);
+  delete static_cast<GstPylonLazyChunks *>(pylon_meta->lazy_chunks);
+}
+
+static gboolean gst_pylon_meta_transform(GstBuffer *transbuf, GstMeta *meta,
+                                         GstBuffer *buffer, GQuark type,
+                                         gpointer data) {
+  GstPylonMeta *smeta = (GstPylonMeta *)meta;
+  GstPylonMeta *dmeta = NULL;
+  gboolean is_copy = GST_META_TRANSFORM_IS_COPY(type);
+  gboolean is_scale = GST_VIDEO_META_TRANSFORM_IS_SCALE(type);
+
+  if (!is_copy && !is_scale) {
+    return FALSE;
+  }
+
+  /* A region copy moves the image origin on the sensor. A copy starting
+   * mid-row needs the pixel size to locate its first column, without it
+   * the offsets can't be told and the meta is not copied. */
+  GstMetaTransformCopy *copy = is_copy ? (GstMetaTransformCopy *)data : NULL;
+  guint64 offset_x = smeta->offset.offset_x;
+  guint64 offset_y = smeta->offset.offset_y;
+  if (copy && copy->region && smeta->stride > 0) {
+    gsize column_bytes = copy->offset % smeta->stride;
+    offset_y += copy->offset / smeta->stride;
+
+    if (column_bytes > 0) {
+      GstVideoMeta *vmeta = gst_buffer_get_video_meta(buffer);
+      const GstVideoFormatInfo *finfo =
+          vmeta ? gst_video_format_get_info(vmeta->format) : NULL;
+      gint pixel_stride = finfo ? GST_VIDEO_FORMAT_INFO_PSTRIDE(finfo, 0) : 0;
+
+      if (pixel_stride <= 0 || 0 != column_bytes % pixel_stride) {
+        GST_DEBUG("Not copying the pylon meta of a region starting mid-row");
+        return FALSE;
+      }
+      offset_x += column_bytes / pixel_stride;
+    }
+  }
+
+  /* Decode pending chunks now, the copy must not keep the pylon grab buffer
+   * alive */
+  gst_pylon_meta_ensure_chunks(smeta);
+
+  dmeta = (GstPylonMeta *)gst_buffer_add_meta(transbuf, GST_PYLON_META_INFO,
+                                              NULL);
+  if (!dmeta) {
+    return FALSE;
+  }
+
+  dmeta->block_id = smeta->block_id;
+  dmeta->image_number = smeta->image_number;
+  dmeta->skipped_images = smeta->skipped_images;
+  dmeta->offset.offset_x = offset_x;
+  dmeta->offset.offset_y = offset_y;
+  dmeta->timestamp = smeta->timestamp;
+  dmeta->stride = smeta->stride;
+  dmeta->n_chunk_values = smeta->n_chunk_values;
+  memcpy(dmeta->chunk_values, smeta->chunk_values,
+         smeta->n_chunk_values * sizeof(GstPylonChunk));
+  for (guint i = 0; i < dmeta->n_chunk_values; i++) {
+    GstPylonChunk *chunk = &dmeta->chunk_values[i];
+    if (GST_PYLON_CHUNK_TYPE_STRING == chunk->type) {
+      chunk->value.v_string = g_strdup(chunk->value.v_string);
+    }
+  }
+
+  if (is_scale) {
+    GstVideoMetaTransform *trans = (GstVideoMetaTransform *)data;
+
+    /* Offsets stay in sensor coordinates, only the memory layout changed */
+    dmeta->stride = GST_VIDEO_INFO_PLANE_STRIDE(trans->out_info, 0);
+  }
+
+  return TRUE;
+}
+
+static void gst_pylon_meta_reset(GstPylonMeta *self) {
+  GstPylonLazyChunks *lazy =
+      static_cast<GstPylonLazyChunks *>(self->lazy_chunks);
+
+  if (self->chunks) {
+    gst_structure_free(self->chunks);
+    self->chunks = NULL;
+  }
+
+  for (guint i = 0; i < self->n_chunk_values; i++) {
+    GstPylonChunk *chunk = &self->chunk_values[i];
+    if (GST_PYLON_CHUNK_TYPE_STRING == chunk->type) {
+      g_free(const_cast<gchar *>(chunk->value.v_string));
+    }
+  }
+  self->n_chunk_values = 0;
+
+  if (lazy && lazy->cache) {
+    lazy->grab_result.Release();
+    gst_pylon_chunk_cache_unref(lazy->cache);
+    lazy->cache = NULL;
+  }
+}
+
+guint gst_pylon_meta_get_n_chunks(const GstPylonMeta *self) {
+  g_return_val_if_fail(self, 0);
+
+  gst_pylon_meta_ensure_chunks(self);
+
+  return self->n_chunk_values;
+}
+
+const GstPylonChunk *gst_pylon_meta_get_chunk(const GstPylonMeta *self,
+                                              guint index) {
+  g_return_val_if_fail(self, NULL);
+
+  gst_pylon_meta_ensure_chunks(self);
+
+  g_return_val_if_fail(index < self->n_chunk_values, NULL);
+
+  return &self->chunk_values[index];
+}
+
+const GstPylonChunk *gst_pylon_meta_find_chunk(const GstPylonMeta *self,
+                                               const gchar *name) {
+  g_return_val_if_fail(self, NULL);
+  g_return_val_if_fail(name, NULL);
+
+  /* Chunk names are interned while the meta is filled, a name without a
+   * quark can't be present */
+  GQuark quark = g_quark_try_string(name);
+  if (0 == quark) {
+    return NULL;
+  }
+
+  gst_pylon_meta_ensure_chunks(self);
+
+  for (guint i = 0; i < self->n_chunk_values; i++) {
+    if (self->chunk_values[i].name == quark) {
+      return &self->chunk_values[i];
+    }
+  }
+
+  return NULL;
+}
+
+gboolean gst_pylon_meta_get_chunk_int64(const GstPylonMeta *self,
+                                        const gchar *name, gint64 *value) {
+  g_return_val_if_fail(value, FALSE);
+
+  const GstPylonChunk *chunk = gst_pylon_meta_find_chunk(self, name);
+  if (!chunk || GST_PYLON_CHUNK_TYPE_INT64 != chunk->type) {
+    return FALSE;
+  }
+
+  *value = chunk->value.v_int64;
+  return TRUE;
+}
+
+gboolean gst_pylon_meta_get_chunk_boolean(const GstPylonMeta *self,
+                                          const gchar *name, gboolean *value) {
+  g_return_val_if_fail(value, FALSE);
+
+  const GstPylonChunk *chunk = gst_pylon_meta_find_chunk(self, name);
+  if (!chunk || GST_PYLON_CHUNK_TYPE_BOOLEAN != chunk->type) {
+    return FALSE;
+  }
+
+  *value = chunk->value.v_boolean;
+  return TRUE;
+}
+
+gboolean gst_pylon_meta_get_chunk_double(const GstPylonMeta *self,
+                                         const gchar *name, gdouble *value) {
+  g_return_val_if_fail(value, FALSE);
+
+  const GstPylonChunk *chunk = gst_pylon_meta_find_chunk(self, name);
+  if (!chunk || GST_PYLON_CHUNK_TYPE_DOUBLE != chunk->type) {
+    return FALSE;
+  }
+
+  *value = chunk->value.v_double;
+  return TRUE;
+}
+
+gboolean gst_pylon_meta_get_chunk_string(const GstPylonMeta *self,
+                                         const gchar *name,
+                                         const gchar **value) {
+  g_return_val_if_fail(value, FALSE);
+
+  const GstPylonChunk *chunk = gst_pylon_meta_find_chunk(self, name);
+  if (!chunk || GST_PYLON_CHUNK_TYPE_STRING != chunk->type) {
+    return FALSE;
+  }
+
+  *value = chunk->value.v_string;
+  return TRUE;
+}
+
+const GstStructure *gst_pylon_meta_get_chunks(GstPylonMeta *self) {
+  g_return_val_if_fail(self, NULL);
+
+  /* Several downstream threads may ask for the structure at once */
+  gst_pylon_meta_ensure_chunks(self);
+
+  if (g_once_init_enter(&self->chunks)) {
+    GstStructure *st = gst_structure_new_empty("meta/x-pylon");
+
+    for (guint i = 0; i < self->n_chunk_values; i++) {
+      const GstPylonChunk *chunk = &self->chunk_values[i];
+
+      switch (chunk->type) {
+        case GST_PYLON_CHUNK_TYPE_INT64:
+          gst_structure_id_set(st, chunk->name, G_TYPE_INT64,
+                               chunk->value.v_int64, NULL);
+          break;
+        case GST_PYLON_CHUNK_TYPE_BOOLEAN:
+          gst_structure_id_set(st, chunk->name, G_TYPE_BOOLEAN,
+                               chunk->value.v_boolean, NULL);
+          break;
+        case GST_PYLON_CHUNK_TYPE_DOUBLE:
+          gst_structure_id_set(st, chunk->name, G_TYPE_DOUBLE,
+                               chunk->value.v_double, NULL);
+          break;
+        case GST_PYLON_CHUNK_TYPE_STRING:
+          gst_structure_id_set(st, chunk->name, G_TYPE_STRING,
+                               chunk->value.v_string, NULL);
+          break;
+      }
+    }
+
+    g_once_init_leave(&self->chunks, st);
+  }
+
+  return self->chunks;
 }
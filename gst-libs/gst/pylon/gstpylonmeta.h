@@ -40,19 +40,47 @@ G_BEGIN_DECLS
 
 #define GST_PYLON_META_API_TYPE (gst_pylon_meta_api_get_type())
 #define GST_PYLON_META_INFO (gst_pylon_meta_get_info())
+#define GST_PYLON_META_MAX_CHUNKS 64
 typedef struct _GstPylonOffset GstPylonOffset;
+typedef struct _GstPylonChunk GstPylonChunk;
 typedef struct _GstPylonMeta GstPylonMeta;
 
+typedef enum
+{
+  GST_PYLON_CHUNK_TYPE_INT64,
+  GST_PYLON_CHUNK_TYPE_BOOLEAN,
+  GST_PYLON_CHUNK_TYPE_DOUBLE,
+  GST_PYLON_CHUNK_TYPE_STRING,
+} GstPylonChunkType;
+
 struct _GstPylonOffset
 {
   guint64 offset_x;
   guint64 offset_y;
 };
 
+/* A single chunk value. Names follow the chunk feature name, with the
+ * selector entry appended for selected chunks (e.g. "CounterValue-Counter1").
+ * String and enumeration chunks are owned by the meta and valid as long as
+ * it is. */
+struct _GstPylonChunk
+{
+  GQuark name;
+  GstPylonChunkType type;
+  union
+  {
+    gint64 v_int64;
+    gboolean v_boolean;
+    gdouble v_double;
+    const gchar *v_string;
+  } value;
+};
+
 struct _GstPylonMeta
 {
   GstMeta meta;
 
+  /* Created on first use, access through gst_pylon_meta_get_chunks() */
   GstStructure *chunks;
   guint64 block_id;
   guint64 image_number;
@@ -60,10 +88,34 @@ struct _GstPylonMeta
   GstPylonOffset offset;
   GstClockTime timestamp;
   gsize stride;
+
+  /* Filled on first access when chunks are decoded lazily, read them through
+   * gst_pylon_meta_get_n_chunks() and gst_pylon_meta_get_chunk() */
+  guint n_chunk_values;
+  GstPylonChunk chunk_values[GST_PYLON_META_MAX_CHUNKS];
+
+  /* private */
+  gpointer lazy_chunks;
 };
 
 EXT_PYLONSRC_API GType gst_pylon_meta_api_get_type (void);
 EXT_PYLONSRC_API const GstMetaInfo *gst_pylon_meta_get_info (void);
 
+EXT_PYLONSRC_API guint gst_pylon_meta_get_n_chunks (const GstPylonMeta * self);
+EXT_PYLONSRC_API const GstPylonChunk *gst_pylon_meta_get_chunk (
+    const GstPylonMeta * self, guint index);
+EXT_PYLONSRC_API const GstPylonChunk *gst_pylon_meta_find_chunk (
+    const GstPylonMeta * self, const gchar * name);
+EXT_PYLONSRC_API gboolean gst_pylon_meta_get_chunk_int64 (
+    const GstPylonMeta * self, const gchar * name, gint64 * value);
+EXT_PYLONSRC_API gboolean gst_pylon_meta_get_chunk_boolean (
+    const GstPylonMeta * self, const gchar * name, gboolean * value);
+EXT_PYLONSRC_API gboolean gst_pylon_meta_get_chunk_double (
+    const GstPylonMeta * self, const gchar * name, gdouble * value);
+EXT_PYLONSRC_API gboolean gst_pylon_meta_get_chunk_string (
+    const GstPylonMeta * self, const gchar * name, const gchar ** value);
+EXT_PYLONSRC_API const GstStructure *gst_pylon_meta_get_chunks (
+    GstPylonMeta * self);
+
 G_END_DECLS
 #endif
@@ -58,9 +58,24 @@
 
 G_BEGIN_DECLS
 
+typedef struct _GstPylonChunkCache GstPylonChunkCache;
+
+typedef enum {
+  GST_PYLON_CHUNK_DECODING_EAGER,
+  GST_PYLON_CHUNK_DECODING_LAZY,
+  GST_PYLON_CHUNK_DECODING_OFF,
+} GstPylonChunkDecoding;
+
+EXT_PYLONSRC_API GstPylonChunkCache *gst_pylon_chunk_cache_new(
+    GenApi::INodeMap &nodemap);
+EXT_PYLONSRC_API void gst_pylon_chunk_cache_free(GstPylonChunkCache *cache);
+EXT_PYLONSRC_API void gst_pylon_chunk_cache_invalidate(
+    GstPylonChunkCache *cache);
+
 EXT_PYLONSRC_API void gst_buffer_add_pylon_meta(
     GstBuffer *buffer,
-    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr);
+    const Pylon::CBaslerUniversalGrabResultPtr &grab_result_ptr,
+    GstPylonChunkCache *cache, GstPylonChunkDecoding decoding);
 
 G_END_DECLS
 
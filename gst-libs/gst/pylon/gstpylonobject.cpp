@@ -34,22 +34,88 @@
 #include "config.h"
 #endif
 
+#include "gstpyloncache.h"
 #include "gstpylondebug.h"
 #include "gstpylonfeaturewalker.h"
+#include "gstpylonintrospection.h"
 #include "gstpylonobject.h"
 #include "gstpylonparamspecs.h"
 
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <unordered_map>
 #include <utility>
+#include <vector>
+
+#define CACHE_QSTRING "GstPylonObjectCache"
+
+/* Serializes the access to the feature caches of the classes */
+static std::mutex cache_mutex;
+
+typedef struct _GstPylonObjectFeatureNodes GstPylonObjectFeatureNodes;
+struct _GstPylonObjectFeatureNodes {
+  GenApi::INode* feature;
+  GenApi::INode* selector;
+  guint64 selector_value;
+};
+
+/* Limits of a feature under all settings, only the pair matching the type
+ * of the feature is used */
+typedef struct _GstPylonObjectLimits GstPylonObjectLimits;
+struct _GstPylonObjectLimits {
+  gint64 int_min;
+  gint64 int_max;
+  gdouble float_min;
+  gdouble float_max;
+};
 
 typedef struct _GstPylonObjectPrivate GstPylonObjectPrivate;
 struct _GstPylonObjectPrivate {
   std::shared_ptr<Pylon::CBaslerUniversalInstantCamera> camera;
   GenApi::INodeMap* nodemap;
+  /* Feature and selector nodes indexed by property id, resolved once when
+   * the object is created */
+  std::vector<GstPylonObjectFeatureNodes> nodes;
+  /* Value last written to each selector, dropped when the selector node
+   * changes outside of the property access */
+  std::mutex selectors_mutex;
+  std::unordered_map<GenApi::INode*, guint64> selected;
+  std::vector<std::pair<GenApi::INode*, GenApi::CallbackHandleType>>
+      callbacks;
+
+  /* Limits explored by this object, on the first write of a provisional
+   * param spec or by refresh-limits */
+  std::mutex limits_mutex;
+  std::unordered_map<GenApi::INode*, GstPylonObjectLimits> limits;
+
+  /* Named feature snapshots in PFS text format */
+  std::mutex snapshots_mutex;
+  std::map<std::string, std::string> snapshots;
+  /* Feature values of the last applied or captured snapshot, keyed by
+   * gst_pylon_object_get_snapshot_key. Dropped when features are written
+   * outside of a snapshot. Taken after the nodemap lock. */
+  std::mutex state_mutex;
+  std::unordered_map<std::string, std::string> state;
+
+  void OnSelectorChanged(GenApi::INode* node) {
+    std::lock_guard<std::mutex> lock(this->selectors_mutex);
+    this->selected.erase(node);
+  }
+};
+
+typedef struct _GstPylonObjectPendingFeature GstPylonObjectPendingFeature;
+struct _GstPylonObjectPendingFeature {
+  GParamSpec* pspec;
+  GValue value;
+  std::string error;
 };
 
 typedef struct _GstPylonObjectDeviceMembers GstPylonObjectDeviceMembers;
 struct _GstPylonObjectDeviceMembers {
   const gchar* device_name;
+  gchar* cache_name;
   GenApi::INodeMap& nodemap;
 };
 
@@ -75,9 +141,24 @@ static inline gpointer gst_pylon_object_get_instance_private(
 }
 
 GType gst_pylon_object_register(const Pylon::String_t& device_name,
+                                const std::string& cache_name,
                                 GenApi::INodeMap& exemplar) {
+  /* Devices may be registered from multiple threads */
+  static std::mutex register_mutex;
+  std::lock_guard<std::mutex> lock(register_mutex);
+
+  /* Convert camera name to a valid string */
+  gchar* type_name = gst_pylon_param_spec_sanitize_name(device_name.c_str());
+
+  GType type = g_type_from_name(type_name);
+  if (type) {
+    /* Already registered, e.g. while inspecting the element */
+    g_free(type_name);
+    return type;
+  }
+
   GstPylonObjectDeviceMembers* device_members = new GstPylonObjectDeviceMembers(
-      {g_strdup(device_name.c_str()), exemplar});
+      {g_strdup(device_name.c_str()), g_strdup(cache_name.c_str()), exemplar});
 
   GTypeInfo typeinfo = {
       sizeof(GstPylonObjectClass),
@@ -91,14 +172,8 @@ GType gst_pylon_object_register(const Pylon::String_t& device_name,
       (GInstanceInitFunc)gst_pylon_object_init,
   };
 
-  /* Convert camera name to a valid string */
-  gchar* type_name = gst_pylon_param_spec_sanitize_name(device_name.c_str());
-
-  GType type = g_type_from_name(type_name);
-  if (!type) {
-    type = g_type_register_static(GST_TYPE_OBJECT, type_name, &typeinfo,
-                                  static_cast<GTypeFlags>(0));
-  }
+  type = g_type_register_static(GST_TYPE_OBJECT, type_name, &typeinfo,
+                                static_cast<GTypeFlags>(0));
 
   g_free(type_name);
 
@@ -108,6 +183,19 @@ GType gst_pylon_object_register(const Pylon::String_t& device_name,
   return type;
 }
 
+void gst_pylon_object_fill_cache(const Pylon::String_t& device_name,
+                                 const std::string& cache_name,
+                                 GenApi::INodeMap& nodemap) {
+  GstPylonCache cache(cache_name);
+
+  /* The class init of a later registration finds the explored features in
+   * the cache and only has to create the param specs. Callers must not fill
+   * the same cache from multiple threads. */
+  cache.load();
+  GstPylonFeatureWalker::fill_cache(nodemap, device_name.c_str(), cache);
+  cache.save();
+}
+
 /************************************************************
  * End of GObject definition
  ***********************************************************/
@@ -115,52 +203,93 @@ GType gst_pylon_object_register(const Pylon::String_t& device_name,
 /* prototypes */
 static void gst_pylon_object_install_properties(GstPylonObjectClass* klass,
                                                 GenApi::INodeMap& nodemap,
-                                                const gchar* device_fullname);
+                                                const gchar* device_fullname,
+                                                const gchar* cache_name);
 template <typename F, typename P>
-static void gst_pylon_object_set_pylon_property(GenApi::INodeMap& nodemap,
+static void gst_pylon_object_set_pylon_property(GenApi::INode* node,
                                                 F get_value,
-                                                const GValue* value,
-                                                const gchar* name);
-static void gst_pylon_object_set_enum_property(GenApi::INodeMap& nodemap,
-                                               const GValue* value,
-                                               const gchar* name);
-static void gst_pylon_object_classify_selector(GenApi::INodeMap& nodemap,
-                                               const gchar* selector_name,
-                                               guint64& selector_value);
-template <typename F, typename P>
-static void gst_pylon_object_set_pylon_selector(
-    GenApi::INodeMap& nodemap, F get_value, const GValue* value,
-    const gchar* feature, const gchar* selector, guint64& selector_value);
-static void gst_pylon_object_set_enum_selector(GenApi::INodeMap& nodemap,
-                                               const GValue* value,
-                                               const gchar* feature_name,
-                                               const gchar* selector_name,
-                                               guint64& selector_value);
+                                                const GValue* value);
+static void gst_pylon_object_set_enum_property(GenApi::INode* node,
+                                               const GValue* value);
+static void gst_pylon_object_classify_selector(GenApi::INode* selector,
+                                               guint64 selector_value);
 template <typename T, typename P>
-static T gst_pylon_object_get_pylon_property(GenApi::INodeMap& nodemap,
-                                             const gchar* name);
-static gint gst_pylon_object_get_enum_property(GenApi::INodeMap& nodemap,
-                                               const gchar* name);
-template <typename F, typename P>
-static void gst_pylon_object_classify_feature(
-    GParamSpec* pspec, GstPylonObjectPrivate* priv,
-    GstPylonParamSpecSelectorData* selector_data, F get_value,
-    const GValue* value);
+static T gst_pylon_object_get_pylon_property(GenApi::INode* node);
+static gint gst_pylon_object_get_enum_property(GenApi::INode* node);
+static void gst_pylon_object_select(GstPylonObjectPrivate* priv,
+                                    GenApi::INode* selector,
+                                    guint64 selector_value);
+static GenApi::INode* gst_pylon_object_select_feature(
+    GstPylonObjectPrivate* priv, guint property_id, GParamSpec* pspec);
+static void gst_pylon_object_write_property(GstPylonObject* self,
+                                            guint property_id,
+                                            const GValue* value,
+                                            GParamSpec* pspec);
 static void gst_pylon_object_set_property(GObject* object, guint property_id,
                                           const GValue* value,
                                           GParamSpec* pspec);
 static void gst_pylon_object_get_property(GObject* object, guint property_id,
                                           GValue* value, GParamSpec* pspec);
 static void gst_pylon_object_finalize(GObject* self);
+static GstPylonCache* gst_pylon_object_get_cache(GstPylonObject* self);
+static gboolean gst_pylon_object_explore_limits(GstPylonObject* self,
+                                                GenApi::INode* node,
+                                                GstPylonObjectLimits& limits);
+static void gst_pylon_object_store_limits(
+    GstPylonObject* self,
+    const std::vector<std::pair<GenApi::INode*, GstPylonObjectLimits>>&
+        explored);
+static gboolean gst_pylon_object_check_limits(GstPylonObject* self,
+                                              guint property_id,
+                                              const GValue* value,
+                                              GParamSpec* pspec);
+static void gst_pylon_object_refresh_limits(GstPylonObject* self);
+static gboolean gst_pylon_object_convert_value(GParamSpec* pspec,
+                                               const GValue* field,
+                                               GValue* value);
+static gboolean gst_pylon_object_apply(GstPylonObject* self,
+                                       const GstStructure* features);
+static gboolean gst_pylon_object_capture_snapshot(GstPylonObject* self,
+                                                  const gchar* name);
+static gboolean gst_pylon_object_load_snapshot(GstPylonObject* self,
+                                               const gchar* name,
+                                               const gchar* location);
+static gboolean gst_pylon_object_apply_snapshot(GstPylonObject* self,
+                                                const gchar* name);
+static std::string gst_pylon_object_get_snapshot_key(
+    GenApi::INodeMap& nodemap, const std::string& feature,
+    const std::unordered_map<std::string, std::string>& values);
+template <typename F>
+static void gst_pylon_object_parse_snapshot(GenApi::INodeMap& nodemap,
+                                            const std::string& features,
+                                            F func);
+static void gst_pylon_object_forget_state(GstPylonObjectPrivate* priv);
+static void gst_pylon_object_resolve_nodes(GstPylonObject* self);
+static void gst_pylon_object_track_selector(GstPylonObjectPrivate* priv,
+                                            GenApi::INode* selector);
 
 static void gst_pylon_object_install_properties(GstPylonObjectClass* klass,
                                                 GenApi::INodeMap& nodemap,
-                                                const gchar* device_name) {
+                                                const gchar* device_name,
+                                                const gchar* cache_name) {
   g_return_if_fail(klass);
+  g_return_if_fail(cache_name);
 
+  static GQuark quark = g_quark_from_static_string(CACHE_QSTRING);
   GObjectClass* oclass = G_OBJECT_CLASS(klass);
 
-  GstPylonFeatureWalker::install_properties(oclass, nodemap, device_name);
+  /* The cache outlives the class init, the objects store the limits they
+   * explore in it */
+  GstPylonCache* cache = new GstPylonCache(cache_name);
+  g_type_set_qdata(G_TYPE_FROM_CLASS(klass), quark, cache);
+
+  /* Reuse the limits, flags and enum entries of a previous run on the same
+   * device model. Features without cached limits get provisional specs. */
+  std::lock_guard<std::mutex> cache_lock(cache_mutex);
+  cache->load();
+  GstPylonFeatureWalker::install_properties(oclass, nodemap, device_name,
+                                            *cache);
+  cache->save();
 }
 
 static void gst_pylon_object_class_init(
@@ -171,101 +300,346 @@ static void gst_pylon_object_class_init(
   oclass->get_property = gst_pylon_object_get_property;
   oclass->finalize = gst_pylon_object_finalize;
 
+  g_signal_new_class_handler(
+      "refresh-limits", G_TYPE_FROM_CLASS(klass),
+      static_cast<GSignalFlags>(G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+      G_CALLBACK(gst_pylon_object_refresh_limits), NULL, NULL, NULL,
+      G_TYPE_NONE, 0);
+
+  g_signal_new_class_handler(
+      "apply", G_TYPE_FROM_CLASS(klass),
+      static_cast<GSignalFlags>(G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+      G_CALLBACK(gst_pylon_object_apply), NULL, NULL, NULL, G_TYPE_BOOLEAN, 1,
+      GST_TYPE_STRUCTURE);
+
+  g_signal_new_class_handler(
+      "capture-snapshot", G_TYPE_FROM_CLASS(klass),
+      static_cast<GSignalFlags>(G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+      G_CALLBACK(gst_pylon_object_capture_snapshot), NULL, NULL, NULL,
+      G_TYPE_BOOLEAN, 1, G_TYPE_STRING);
+
+  g_signal_new_class_handler(
+      "load-snapshot", G_TYPE_FROM_CLASS(klass),
+      static_cast<GSignalFlags>(G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+      G_CALLBACK(gst_pylon_object_load_snapshot), NULL, NULL, NULL,
+      G_TYPE_BOOLEAN, 2, G_TYPE_STRING, G_TYPE_STRING);
+
+  g_signal_new_class_handler(
+      "apply-snapshot", G_TYPE_FROM_CLASS(klass),
+      static_cast<GSignalFlags>(G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+      G_CALLBACK(gst_pylon_object_apply_snapshot), NULL, NULL, NULL,
+      G_TYPE_BOOLEAN, 1, G_TYPE_STRING);
+
   gst_pylon_object_install_properties(klass, device_members->nodemap,
-                                      device_members->device_name);
+                                      device_members->device_name,
+                                      device_members->cache_name);
 
+  g_free(device_members->cache_name);
   delete (device_members);
 }
 
-static void gst_pylon_object_init(GstPylonObject* self) {}
+static void gst_pylon_object_init(GstPylonObject* self) {
+  GstPylonObjectPrivate* priv =
+      (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
+
+  /* The private data holds C++ members, construct them in place */
+  new (priv) GstPylonObjectPrivate();
+}
+
+static GstPylonCache* gst_pylon_object_get_cache(GstPylonObject* self) {
+  static GQuark quark = g_quark_from_static_string(CACHE_QSTRING);
+
+  return static_cast<GstPylonCache*>(
+      g_type_get_qdata(G_OBJECT_TYPE(self), quark));
+}
+
+/* Exploring the limits writes the features that influence them, which
+ * isn't possible while grabbing. Returns FALSE if the limits are unknown. */
+static gboolean gst_pylon_object_explore_limits(GstPylonObject* self,
+                                                GenApi::INode* node,
+                                                GstPylonObjectLimits& limits) {
+  GstPylonObjectPrivate* priv =
+      (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
+
+  GenApi::EInterfaceType type = node->GetPrincipalInterfaceType();
+
+  /* Only numeric features have limits */
+  if (GenApi::intfIInteger != type && GenApi::intfIFloat != type) {
+    return FALSE;
+  }
+
+  if (!priv->camera || priv->camera->IsGrabbing()) {
+    return FALSE;
+  }
+
+  try {
+    GenApi::AutoLock lock(priv->nodemap->GetLock());
+
+    /* The features written by the exploration no longer match the state of
+     * the last snapshot */
+    gst_pylon_object_forget_state(priv);
+
+    if (GenApi::intfIInteger == type) {
+      GstPylonParamFactory::explore_limits(node, limits.int_min,
+                                           limits.int_max);
+    } else {
+      GstPylonParamFactory::explore_limits(node, limits.float_min,
+                                           limits.float_max);
+    }
+  } catch (const Pylon::GenericException& e) {
+    GST_WARNING_OBJECT(self, "Unable to explore limits of \"%s\": %s",
+                       node->GetName().c_str(), e.GetDescription());
+    return FALSE;
+  }
+
+  std::lock_guard<std::mutex> lock(priv->limits_mutex);
+  priv->limits[node] = limits;
+
+  return TRUE;
+}
+
+/* The specs of the class keep their ranges, the next plugin load installs
+ * the stored limits */
+static void gst_pylon_object_store_limits(
+    GstPylonObject* self,
+    const std::vector<std::pair<GenApi::INode*, GstPylonObjectLimits>>&
+        explored) {
+  GstPylonCache* cache = gst_pylon_object_get_cache(self);
+
+  if (!cache || explored.empty()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> cache_lock(cache_mutex);
+
+  for (const auto& feature : explored) {
+    const gchar* name = feature.first->GetName();
+    const GstPylonObjectLimits& limits = feature.second;
+
+    if (GenApi::intfIInteger == feature.first->GetPrincipalInterfaceType()) {
+      cache->set_int_limits(name, limits.int_min, limits.int_max);
+    } else {
+      cache->set_double_limits(name, limits.float_min, limits.float_max);
+    }
+  }
+  cache->save();
+}
+
+/* GObject validates values against the range of the spec, which is the full
+ * range of the type for provisional specs and may be outdated after
+ * refresh-limits. Check them against the limits explored by this object as
+ * well, the first write of a provisional spec explores them. While
+ * grabbing, unknown limits are left to the device to check. */
+static gboolean gst_pylon_object_check_limits(GstPylonObject* self,
+                                              guint property_id,
+                                              const GValue* value,
+                                              GParamSpec* pspec) {
+  GstPylonObjectPrivate* priv =
+      (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
+  GstPylonObjectLimits limits = {0, 0, 0, 0};
+  gboolean known = FALSE;
+
+  if (property_id >= priv->nodes.size() || !priv->nodes[property_id].feature) {
+    return TRUE;
+  }
+
+  GenApi::INode* node = priv->nodes[property_id].feature;
+
+  {
+    std::lock_guard<std::mutex> lock(priv->limits_mutex);
+    auto it = priv->limits.find(node);
+    if (it != priv->limits.end()) {
+      limits = it->second;
+      known = TRUE;
+    }
+  }
+
+  if (!known) {
+    if (!GstPylonParamFactory::is_provisional(pspec) ||
+        !gst_pylon_object_explore_limits(self, node, limits)) {
+      return TRUE;
+    }
+    gst_pylon_object_store_limits(self, {{node, limits}});
+  }
+
+  switch (g_type_fundamental(pspec->value_type)) {
+    case G_TYPE_INT64:
+      return g_value_get_int64(value) >= limits.int_min &&
+             g_value_get_int64(value) <= limits.int_max;
+    case G_TYPE_FLOAT:
+      return g_value_get_float(value) >= limits.float_min &&
+             g_value_get_float(value) <= limits.float_max;
+    default:
+      return TRUE;
+  }
+}
+
+/* Explores the limits of all numeric features of this object again. They
+ * are used to check the writes of this object right away and stored in the
+ * feature cache. */
+static void gst_pylon_object_refresh_limits(GstPylonObject* self) {
+  GstPylonObjectPrivate* priv =
+      (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
+  std::set<GenApi::INode*> visited;
+  std::vector<std::pair<GenApi::INode*, GstPylonObjectLimits>> explored;
+
+  if (!priv->camera) {
+    return;
+  }
+
+  if (priv->camera->IsGrabbing()) {
+    GST_WARNING_OBJECT(self, "Unable to refresh limits while grabbing");
+    return;
+  }
+
+  for (const auto& nodes : priv->nodes) {
+    GstPylonObjectLimits limits = {0, 0, 0, 0};
+
+    /* Selected features share the limits of all their selector values */
+    if (!nodes.feature || !visited.insert(nodes.feature).second) {
+      continue;
+    }
+
+    if (gst_pylon_object_explore_limits(self, nodes.feature, limits)) {
+      explored.push_back({nodes.feature, limits});
+    }
+  }
+
+  gst_pylon_object_store_limits(self, explored);
+}
 
 template <typename F, typename P>
-static void gst_pylon_object_set_pylon_property(GenApi::INodeMap& nodemap,
+static void gst_pylon_object_set_pylon_property(GenApi::INode* node,
                                                 F get_value,
-                                                const GValue* value,
-                                                const gchar* name) {
-  P param(nodemap, name);
+                                                const GValue* value) {
+  P param(node);
   param.SetValue(get_value(value));
 }
 
-static void gst_pylon_object_set_enum_property(GenApi::INodeMap& nodemap,
-                                               const GValue* value,
-                                               const gchar* name) {
-  Pylon::CEnumParameter param(nodemap, name);
+static void gst_pylon_object_set_enum_property(GenApi::INode* node,
+                                               const GValue* value) {
+  Pylon::CEnumParameter param(node);
   param.SetIntValue(g_value_get_enum(value));
 }
 
-static void gst_pylon_object_classify_selector(GenApi::INodeMap& nodemap,
-                                               const gchar* selector_name,
-                                               guint64& selector_value) {
-  gint selector_type =
-      nodemap.GetNode(selector_name)->GetPrincipalInterfaceType();
+static void gst_pylon_object_classify_selector(GenApi::INode* selector,
+                                               guint64 selector_value) {
+  gint selector_type = selector->GetPrincipalInterfaceType();
   switch (selector_type) {
     case GenApi::intfIEnumeration:
-      Pylon::CEnumParameter(nodemap, selector_name).SetIntValue(selector_value);
+      Pylon::CEnumParameter(selector).SetIntValue(selector_value);
       break;
     case GenApi::intfIInteger:
-      Pylon::CIntegerParameter(nodemap, selector_name).SetValue(selector_value);
+      Pylon::CIntegerParameter(selector).SetValue(selector_value);
       break;
     default:
-      std::string error_msg = "Selector \"" + std::string(selector_name) +
-                              "\"" + " is of invalid type " +
+      std::string error_msg = "Selector \"" +
+                              std::string(selector->GetName().c_str()) + "\"" +
+                              " is of invalid type " +
                               std::to_string(selector_type);
       g_warning("%s", error_msg.c_str());
       throw Pylon::GenericException(error_msg.c_str(), __FILE__, __LINE__);
   }
 }
 
-template <typename F, typename P>
-static void gst_pylon_object_set_pylon_selector(GenApi::INodeMap& nodemap,
-                                                F get_value,
-                                                const GValue* value,
-                                                const gchar* feature_name,
-                                                const gchar* selector_name,
-                                                guint64& selector_value) {
-  gst_pylon_object_classify_selector(nodemap, selector_name, selector_value);
+template <typename T, typename P>
+static T gst_pylon_object_get_pylon_property(GenApi::INode* node) {
+  P param(node);
+  return param.GetValue();
+}
 
-  gst_pylon_object_set_pylon_property<F, P>(nodemap, get_value, value,
-                                            feature_name);
+static gint gst_pylon_object_get_enum_property(GenApi::INode* node) {
+  Pylon::CEnumParameter param(node);
+  return param.GetIntValue();
 }
 
-static void gst_pylon_object_set_enum_selector(GenApi::INodeMap& nodemap,
-                                               const GValue* value,
-                                               const gchar* feature_name,
-                                               const gchar* selector_name,
-                                               guint64& selector_value) {
-  gst_pylon_object_classify_selector(nodemap, selector_name, selector_value);
+static void gst_pylon_object_select(GstPylonObjectPrivate* priv,
+                                    GenApi::INode* selector,
+                                    guint64 selector_value) {
+  {
+    std::lock_guard<std::mutex> lock(priv->selectors_mutex);
+    auto it = priv->selected.find(selector);
+    if (it != priv->selected.end() && it->second == selector_value) {
+      return;
+    }
+  }
 
-  gst_pylon_object_set_enum_property(nodemap, value, feature_name);
-}
+  /* The selector is not part of the snapshot state, but the snapshot may
+   * expect another entry to be selected */
+  gst_pylon_object_forget_state(priv);
 
-template <typename T, typename P>
-static T gst_pylon_object_get_pylon_property(GenApi::INodeMap& nodemap,
-                                             const gchar* name) {
-  P param(nodemap, name);
-  return param.GetValue();
+  /* Writing the selector notifies its own callback, remember the value once
+   * the write is done */
+  gst_pylon_object_classify_selector(selector, selector_value);
+
+  std::lock_guard<std::mutex> lock(priv->selectors_mutex);
+  priv->selected[selector] = selector_value;
 }
 
-static gint gst_pylon_object_get_enum_property(GenApi::INodeMap& nodemap,
-                                               const gchar* name) {
-  Pylon::CEnumParameter param(nodemap, name);
-  return param.GetIntValue();
+static GenApi::INode* gst_pylon_object_select_feature(
+    GstPylonObjectPrivate* priv, guint property_id, GParamSpec* pspec) {
+  if (property_id >= priv->nodes.size() ||
+      !priv->nodes[property_id].feature) {
+    std::string msg =
+        "Feature node of \"" + std::string(pspec->name) + "\" not found";
+    throw Pylon::GenericException(msg.c_str(), __FILE__, __LINE__);
+  }
+
+  const GstPylonObjectFeatureNodes& nodes = priv->nodes[property_id];
+
+  /* The value accessed through the pspec can be a direct feature or a
+   * feature that has a selector. Select the value the pspec refers to
+   * before accessing the feature. */
+  if (nodes.selector) {
+    gst_pylon_object_select(priv, nodes.selector, nodes.selector_value);
+  }
+
+  return nodes.feature;
 }
 
-template <typename F, typename P>
-static void gst_pylon_object_classify_feature(
-    GParamSpec* pspec, GstPylonObjectPrivate* priv,
-    GstPylonParamSpecSelectorData* selector_data, F get_value,
-    const GValue* value) {
-  /* The value accepted by the pspec can be a direct feature or a feature that
-   * has a selector. */
-  if (GST_PYLON_PARAM_FLAG_IS_SET(pspec, GST_PYLON_PARAM_IS_SELECTOR)) {
-    gst_pylon_object_set_pylon_selector<F, P>(
-        *priv->nodemap, get_value, value, selector_data->feature,
-        selector_data->selector, selector_data->selector_value);
-  } else {
-    gst_pylon_object_set_pylon_property<F, P>(*priv->nodemap, get_value, value,
-                                              pspec->name);
+static void gst_pylon_object_write_property(GstPylonObject* self,
+                                            guint property_id,
+                                            const GValue* value,
+                                            GParamSpec* pspec) {
+  GstPylonObjectPrivate* priv =
+      (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
+  GType value_type = g_type_fundamental(G_VALUE_TYPE(value));
+
+  /* The write may change other features as well */
+  gst_pylon_object_forget_state(priv);
+
+  GenApi::INode* node =
+      gst_pylon_object_select_feature(priv, property_id, pspec);
+
+  switch (value_type) {
+    case G_TYPE_INT64:
+      typedef gint64 (*GGetInt64)(const GValue*);
+      gst_pylon_object_set_pylon_property<GGetInt64, Pylon::CIntegerParameter>(
+          node, g_value_get_int64, value);
+      break;
+    case G_TYPE_BOOLEAN:
+      typedef gboolean (*GGetBool)(const GValue*);
+      gst_pylon_object_set_pylon_property<GGetBool, Pylon::CBooleanParameter>(
+          node, g_value_get_boolean, value);
+      break;
+    case G_TYPE_FLOAT:
+      typedef gfloat (*GGetFloat)(const GValue*);
+      gst_pylon_object_set_pylon_property<GGetFloat, Pylon::CFloatParameter>(
+          node, g_value_get_float, value);
+      break;
+    case G_TYPE_STRING:
+      typedef const gchar* (*GGetString)(const GValue*);
+      gst_pylon_object_set_pylon_property<GGetString, Pylon::CStringParameter>(
+          node, g_value_get_string, value);
+      break;
+    case G_TYPE_ENUM:
+      gst_pylon_object_set_enum_property(node, value);
+      break;
+    default:
+      g_warning("Unsupported GType: %s", g_type_name(pspec->value_type));
+      std::string msg =
+          "Unsupported GType: " + std::string(g_type_name(pspec->value_type));
+      throw Pylon::GenericException(msg.c_str(), __FILE__, __LINE__);
   }
 }
 
@@ -275,51 +649,16 @@ static void gst_pylon_object_set_property(GObject* object, guint property_id,
   GstPylonObject* self = (GstPylonObject*)object;
   GstPylonObjectPrivate* priv =
       (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
-  GType value_type = g_type_fundamental(G_VALUE_TYPE(value));
-  GstPylonParamSpecSelectorData* selector_data = NULL;
 
-  if (GST_PYLON_PARAM_FLAG_IS_SET(pspec, GST_PYLON_PARAM_IS_SELECTOR)) {
-    selector_data = gst_pylon_param_spec_selector_get_data(pspec);
+  if (!gst_pylon_object_check_limits(self, property_id, value, pspec)) {
+    GST_ERROR("Value of pylon property \"%s\" on \"%s\" is out of range",
+              pspec->name,
+              priv->camera->GetDeviceInfo().GetFriendlyName().c_str());
+    return;
   }
 
   try {
-    switch (value_type) {
-      case G_TYPE_INT64:
-        typedef gint64 (*GGetInt64)(const GValue*);
-        gst_pylon_object_classify_feature<GGetInt64, Pylon::CIntegerParameter>(
-            pspec, priv, selector_data, g_value_get_int64, value);
-        break;
-      case G_TYPE_BOOLEAN:
-        typedef gboolean (*GGetBool)(const GValue*);
-        gst_pylon_object_classify_feature<GGetBool, Pylon::CBooleanParameter>(
-            pspec, priv, selector_data, g_value_get_boolean, value);
-        break;
-      case G_TYPE_FLOAT:
-        typedef gfloat (*GGetFloat)(const GValue*);
-        gst_pylon_object_classify_feature<GGetFloat, Pylon::CFloatParameter>(
-            pspec, priv, selector_data, g_value_get_float, value);
-        break;
-      case G_TYPE_STRING:
-        typedef const gchar* (*GGetString)(const GValue*);
-        gst_pylon_object_classify_feature<GGetString, Pylon::CStringParameter>(
-            pspec, priv, selector_data, g_value_get_string, value);
-        break;
-      case G_TYPE_ENUM:
-        if (GST_PYLON_PARAM_FLAG_IS_SET(pspec, GST_PYLON_PARAM_IS_SELECTOR)) {
-          gst_pylon_object_set_enum_selector(
-              *priv->nodemap, value, selector_data->feature,
-              selector_data->selector, selector_data->selector_value);
-        } else {
-          gst_pylon_object_set_enum_property(*priv->nodemap, value,
-                                             pspec->name);
-        }
-        break;
-      default:
-        g_warning("Unsupported GType: %s", g_type_name(pspec->value_type));
-        std::string msg =
-            "Unsupported GType: " + std::string(g_type_name(pspec->value_type));
-        throw Pylon::GenericException(msg.c_str(), __FILE__, __LINE__);
-    }
+    gst_pylon_object_write_property(self, property_id, value, pspec);
   } catch (const Pylon::GenericException& e) {
     GST_ERROR("Unable to set pylon property \"%s\" on \"%s\": %s", pspec->name,
               priv->camera->GetDeviceInfo().GetFriendlyName().c_str(),
@@ -334,33 +673,39 @@ static void gst_pylon_object_get_property(GObject* object, guint property_id,
       (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
 
   try {
+    GenApi::INode* node =
+        gst_pylon_object_select_feature(priv, property_id, pspec);
+
     switch (g_type_fundamental(pspec->value_type)) {
       case G_TYPE_INT64:
-        g_value_set_int64(value, gst_pylon_object_get_pylon_property<
-                                     gint64, Pylon::CIntegerParameter>(
-                                     *priv->nodemap, pspec->name));
+        g_value_set_int64(
+            value,
+            gst_pylon_object_get_pylon_property<gint64,
+                                                Pylon::CIntegerParameter>(
+                node));
         break;
       case G_TYPE_BOOLEAN:
-        g_value_set_boolean(value, gst_pylon_object_get_pylon_property<
-                                       gboolean, Pylon::CBooleanParameter>(
-                                       *priv->nodemap, pspec->name));
+        g_value_set_boolean(
+            value,
+            gst_pylon_object_get_pylon_property<gboolean,
+                                                Pylon::CBooleanParameter>(
+                node));
         break;
       case G_TYPE_FLOAT:
         g_value_set_float(
             value,
             gst_pylon_object_get_pylon_property<gfloat, Pylon::CFloatParameter>(
-                *priv->nodemap, pspec->name));
+                node));
         break;
       case G_TYPE_STRING:
         g_value_set_string(
             value, gst_pylon_object_get_pylon_property<GenICam::gcstring,
                                                        Pylon::CStringParameter>(
-                       *priv->nodemap, pspec->name)
+                       node)
                        .c_str());
         break;
       case G_TYPE_ENUM:
-        g_value_set_enum(value, gst_pylon_object_get_enum_property(
-                                    *priv->nodemap, pspec->name));
+        g_value_set_enum(value, gst_pylon_object_get_enum_property(node));
         break;
       default:
         g_warning("Unsupported GType: %s", g_type_name(pspec->value_type));
@@ -390,15 +735,382 @@ GObject* gst_pylon_object_new(
   priv->camera = std::move(camera);
   priv->nodemap = nodemap;
 
+  gst_pylon_object_resolve_nodes(self);
+
   return obj;
 }
 
+static void gst_pylon_object_resolve_nodes(GstPylonObject* self) {
+  GstPylonObjectPrivate* priv =
+      (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
+  guint n_specs = 0;
+
+  GParamSpec** specs =
+      g_object_class_list_properties(G_OBJECT_GET_CLASS(self), &n_specs);
+  for (guint i = 0; i < n_specs; i++) {
+    GParamSpec* pspec = specs[i];
+    const gchar* feature_name = pspec->name;
+    GstPylonObjectFeatureNodes nodes = {NULL, NULL, 0};
+
+    /* Skip the properties inherited from the parent classes */
+    if (pspec->owner_type != G_OBJECT_TYPE(self)) {
+      continue;
+    }
+
+    if (GST_PYLON_PARAM_FLAG_IS_SET(pspec, GST_PYLON_PARAM_IS_SELECTOR)) {
+      GstPylonParamSpecSelectorData* selector_data =
+          gst_pylon_param_spec_selector_get_data(pspec);
+      feature_name = selector_data->feature;
+      nodes.selector = priv->nodemap->GetNode(selector_data->selector);
+      nodes.selector_value = selector_data->selector_value;
+      gst_pylon_object_track_selector(priv, nodes.selector);
+    }
+    nodes.feature = priv->nodemap->GetNode(feature_name);
+
+    if (!nodes.feature) {
+      GST_WARNING_OBJECT(self, "Unable to find the node of \"%s\"",
+                         pspec->name);
+    }
+
+    if (pspec->param_id >= priv->nodes.size()) {
+      priv->nodes.resize(pspec->param_id + 1, {NULL, NULL, 0});
+    }
+    priv->nodes[pspec->param_id] = nodes;
+  }
+  g_free(specs);
+}
+
+static void gst_pylon_object_track_selector(GstPylonObjectPrivate* priv,
+                                            GenApi::INode* selector) {
+  if (!selector) {
+    return;
+  }
+
+  for (const auto& callback : priv->callbacks) {
+    if (callback.first == selector) {
+      return;
+    }
+  }
+
+  GenApi::CallbackHandleType handle = GenApi::Register(
+      selector, *priv, &GstPylonObjectPrivate::OnSelectorChanged);
+  priv->callbacks.push_back(std::make_pair(selector, handle));
+}
+
+static gboolean gst_pylon_object_convert_value(GParamSpec* pspec,
+                                               const GValue* field,
+                                               GValue* value) {
+  g_value_init(value, pspec->value_type);
+
+  /* Structures parsed from a string hold enum entries and some numbers as
+   * strings */
+  if (G_VALUE_HOLDS_STRING(field) && !G_VALUE_HOLDS_STRING(value)) {
+    return gst_value_deserialize(value, g_value_get_string(field));
+  }
+
+  return g_value_transform(field, value);
+}
+
+static gboolean gst_pylon_object_apply(GstPylonObject* self,
+                                       const GstStructure* features) {
+  GstPylonObjectPrivate* priv =
+      (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
+  GObjectClass* oclass = G_OBJECT_GET_CLASS(self);
+  std::vector<GstPylonObjectPendingFeature> pending;
+  gboolean ret = TRUE;
+
+  g_return_val_if_fail(features, FALSE);
+
+  for (gint i = 0; i < gst_structure_n_fields(features); i++) {
+    const gchar* name = gst_structure_nth_field_name(features, i);
+    GParamSpec* pspec = g_object_class_find_property(oclass, name);
+
+    if (!pspec || pspec->owner_type != G_OBJECT_TYPE(self) ||
+        !(pspec->flags & G_PARAM_WRITABLE)) {
+      GST_WARNING_OBJECT(self, "No writable feature \"%s\"", name);
+      ret = FALSE;
+      continue;
+    }
+
+    GstPylonObjectPendingFeature feature = {pspec, G_VALUE_INIT, ""};
+    if (!gst_pylon_object_convert_value(
+            pspec, gst_structure_get_value(features, name), &feature.value) ||
+        g_param_value_validate(pspec, &feature.value) ||
+        !gst_pylon_object_check_limits(self, pspec->param_id, &feature.value,
+                                       pspec)) {
+      GST_WARNING_OBJECT(self, "Invalid value for \"%s\"", name);
+      g_value_unset(&feature.value);
+      ret = FALSE;
+      continue;
+    }
+
+    pending.push_back(feature);
+  }
+
+  g_object_freeze_notify(G_OBJECT(self));
+
+  {
+    /* Keep other threads off the nodemap until all features are applied.
+     * Features may only become writable after others were set, e.g. an
+     * offset after the size was reduced, so every pass retries the features
+     * that failed in the previous one until no more progress is made. */
+    GenApi::AutoLock lock(priv->nodemap->GetLock());
+    gsize n_pending = 0;
+
+    while (!pending.empty() && pending.size() != n_pending) {
+      std::vector<GstPylonObjectPendingFeature> failed;
+      n_pending = pending.size();
+
+      for (auto& feature : pending) {
+        try {
+          gst_pylon_object_write_property(self, feature.pspec->param_id,
+                                          &feature.value, feature.pspec);
+          g_object_notify_by_pspec(G_OBJECT(self), feature.pspec);
+          g_value_unset(&feature.value);
+        } catch (const Pylon::GenericException& e) {
+          feature.error = e.GetDescription();
+          failed.push_back(feature);
+        }
+      }
+
+      pending.swap(failed);
+    }
+  }
+
+  for (auto& feature : pending) {
+    GST_WARNING_OBJECT(self, "Unable to apply \"%s\": %s",
+                       feature.pspec->name, feature.error.c_str());
+    g_value_unset(&feature.value);
+    ret = FALSE;
+  }
+
+  g_object_thaw_notify(G_OBJECT(self));
+
+  return ret;
+}
+
+static gboolean gst_pylon_object_capture_snapshot(GstPylonObject* self,
+                                                  const gchar* name) {
+  GstPylonObjectPrivate* priv =
+      (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
+  Pylon::String_t features;
+
+  g_return_val_if_fail(name, FALSE);
+
+  try {
+    Pylon::CFeaturePersistence::SaveToString(features, priv->nodemap);
+  } catch (const Pylon::GenericException& e) {
+    GST_WARNING_OBJECT(self, "Unable to capture snapshot \"%s\": %s", name,
+                       e.GetDescription());
+    return FALSE;
+  }
+
+  std::string snapshot(features.c_str());
+
+  /* Saving walks the selector entries and restores the selectors at the
+   * end, so their values in the snapshot don't tell the current ones */
+  {
+    std::lock_guard<std::mutex> lock(priv->state_mutex);
+    priv->state.clear();
+    gst_pylon_object_parse_snapshot(
+        *priv->nodemap, snapshot,
+        [priv](const std::string& feature, const std::string& value,
+               const std::string& key) {
+          GenApi::CSelectorPtr node = priv->nodemap->GetNode(feature.c_str());
+          if (!key.empty() && !(node && node->IsSelector())) {
+            priv->state[key] = value;
+          }
+        });
+  }
+
+  std::lock_guard<std::mutex> lock(priv->snapshots_mutex);
+  priv->snapshots[name] = snapshot;
+
+  return TRUE;
+}
+
+static gboolean gst_pylon_object_load_snapshot(GstPylonObject* self,
+                                               const gchar* name,
+                                               const gchar* location) {
+  GstPylonObjectPrivate* priv =
+      (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
+  gchar* contents = NULL;
+  GError* error = NULL;
+
+  g_return_val_if_fail(name, FALSE);
+  g_return_val_if_fail(location, FALSE);
+
+  if (!g_file_get_contents(location, &contents, NULL, &error)) {
+    GST_WARNING_OBJECT(self, "Unable to load snapshot \"%s\": %s", name,
+                       error->message);
+    g_error_free(error);
+    return FALSE;
+  }
+
+  std::lock_guard<std::mutex> lock(priv->snapshots_mutex);
+  priv->snapshots[name] = contents;
+  g_free(contents);
+
+  return TRUE;
+}
+
+static gboolean gst_pylon_object_apply_snapshot(GstPylonObject* self,
+                                                const gchar* name) {
+  GstPylonObjectPrivate* priv =
+      (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
+  std::string features;
+  guint written = 0;
+  guint skipped = 0;
+  gboolean ret = TRUE;
+
+  g_return_val_if_fail(name, FALSE);
+
+  {
+    std::lock_guard<std::mutex> lock(priv->snapshots_mutex);
+    auto it = priv->snapshots.find(name);
+    if (it == priv->snapshots.end()) {
+      GST_WARNING_OBJECT(self, "No snapshot \"%s\"", name);
+      return FALSE;
+    }
+    features = it->second;
+  }
+
+  GenApi::AutoLock lock(priv->nodemap->GetLock());
+  std::lock_guard<std::mutex> state_lock(priv->state_mutex);
+
+  /* Only values that differ from the last applied or captured snapshot are
+   * written. The device is only read for features whose value is not
+   * cached by the nodemap, e.g. those changed by the camera itself.
+   * Selectors are always written, the features that follow them go to the
+   * selected entry. */
+  gst_pylon_object_parse_snapshot(
+      *priv->nodemap, features,
+      [&](const std::string& feature, const std::string& value,
+          const std::string& key) {
+        try {
+          GenApi::CValuePtr node = priv->nodemap->GetNode(feature.c_str());
+          if (!node) {
+            throw Pylon::GenericException("Feature not found", __FILE__,
+                                          __LINE__);
+          }
+
+          GenApi::CSelectorPtr selector = node->GetNode();
+          if (selector && selector->IsSelector()) {
+            node->FromString(value.c_str());
+            written++;
+            return;
+          }
+
+          if (GenApi::NoCache == node->GetNode()->GetCachingMode()) {
+            if (GenApi::IsReadable(node) && node->ToString() == value.c_str()) {
+              skipped++;
+              return;
+            }
+          } else if (!key.empty()) {
+            auto known = priv->state.find(key);
+            if (known != priv->state.end() && known->second == value) {
+              skipped++;
+              return;
+            }
+          }
+
+          node->FromString(value.c_str());
+          written++;
+          if (!key.empty()) {
+            priv->state[key] = value;
+          }
+        } catch (const Pylon::GenericException& e) {
+          GST_WARNING_OBJECT(self,
+                             "Unable to apply \"%s\" of snapshot \"%s\": %s",
+                             feature.c_str(), name, e.GetDescription());
+          priv->state.erase(key);
+          ret = FALSE;
+        }
+      });
+
+  GST_DEBUG_OBJECT(self, "Applied snapshot \"%s\": %u written, %u unchanged",
+                   name, written, skipped);
+
+  return ret;
+}
+
+/* Identifies the value of a feature in a snapshot. Selected features hold
+ * one value per selector entry, so the key includes the values their
+ * selectors have at this point of the snapshot. The key is empty if one of
+ * them is unknown. */
+static std::string gst_pylon_object_get_snapshot_key(
+    GenApi::INodeMap& nodemap, const std::string& feature,
+    const std::unordered_map<std::string, std::string>& values) {
+  std::string key = feature;
+  GenApi::CSelectorPtr node = nodemap.GetNode(feature.c_str());
+  GenApi::FeatureList_t selectors;
+
+  if (!node) {
+    return key;
+  }
+
+  node->GetSelectingFeatures(selectors);
+  for (const auto& selector : selectors) {
+    auto value = values.find(std::string(selector->GetNode()->GetName()));
+    if (value == values.end()) {
+      return std::string();
+    }
+    key += "\t" + value->second;
+  }
+
+  return key;
+}
+
+/* Calls func with every feature of a snapshot in PFS format, its value and
+ * its key. Every line holds a feature and its value separated by a tab, in
+ * the order they have to be written. Selectors precede the features they
+ * select. */
+template <typename F>
+static void gst_pylon_object_parse_snapshot(GenApi::INodeMap& nodemap,
+                                            const std::string& features,
+                                            F func) {
+  std::unordered_map<std::string, std::string> values;
+  std::istringstream stream(features);
+  std::string line;
+
+  while (std::getline(stream, line)) {
+    if (!line.empty() && '\r' == line.back()) {
+      line.pop_back();
+    }
+
+    std::size_t tab = line.find('\t');
+    if (line.empty() || '#' == line[0] || std::string::npos == tab) {
+      continue;
+    }
+
+    std::string feature = line.substr(0, tab);
+    std::string value = line.substr(tab + 1);
+
+    values[feature] = value;
+    func(feature, value,
+         gst_pylon_object_get_snapshot_key(nodemap, feature, values));
+  }
+}
+
+static void gst_pylon_object_forget_state(GstPylonObjectPrivate* priv) {
+  std::lock_guard<std::mutex> lock(priv->state_mutex);
+  priv->state.clear();
+}
+
 static void gst_pylon_object_finalize(GObject* object) {
   GstPylonObject* self = (GstPylonObject*)object;
   GstPylonObjectPrivate* priv =
       (GstPylonObjectPrivate*)gst_pylon_object_get_instance_private(self);
 
-  priv->camera = NULL;
+  /* The nodemaps go away when the camera is closed, along with the
+   * callbacks registered on them */
+  if (priv->camera && priv->camera->IsOpen()) {
+    for (auto& callback : priv->callbacks) {
+      callback.first->DeregisterCallback(callback.second);
+    }
+  }
+
+  priv->~GstPylonObjectPrivate();
 
   G_OBJECT_CLASS(gst_pylon_object_parent_class)->finalize(object);
 }
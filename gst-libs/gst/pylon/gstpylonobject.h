@@ -63,7 +63,8 @@ struct _GstPylonObjectClass {
   GstObjectClass parent_class;
 };
 
-EXT_PYLONSRC_API GType gst_pylon_object_register (const Pylon::String_t &device_name, GenApi::INodeMap& nodemap);
+EXT_PYLONSRC_API GType gst_pylon_object_register (const Pylon::String_t &device_name, const std::string &cache_name, GenApi::INodeMap& nodemap);
+EXT_PYLONSRC_API void gst_pylon_object_fill_cache (const Pylon::String_t &device_name, const std::string &cache_name, GenApi::INodeMap& nodemap);
 EXT_PYLONSRC_API GObject* gst_pylon_object_new(
     std::shared_ptr<Pylon::CBaslerUniversalInstantCamera> camera,
     const Pylon::String_t& device_name, GenApi::INodeMap* nodemap);
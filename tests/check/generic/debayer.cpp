@@ -0,0 +1,252 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+#include "gstpylondebayer.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+static const GstPylonDebayerPattern patterns[] = {
+    GST_PYLON_DEBAYER_PATTERN_RGGB, GST_PYLON_DEBAYER_PATTERN_BGGR,
+    GST_PYLON_DEBAYER_PATTERN_GRBG, GST_PYLON_DEBAYER_PATTERN_GBRG};
+static const GstPylonDebayerMethod methods[] = {
+    GST_PYLON_DEBAYER_BILINEAR, GST_PYLON_DEBAYER_HIGH_QUALITY};
+static const GstPylonDebayerOutput outputs[] = {
+    GST_PYLON_DEBAYER_OUTPUT_RGB, GST_PYLON_DEBAYER_OUTPUT_BGRX,
+    GST_PYLON_DEBAYER_OUTPUT_GRAY8};
+
+/* Colors of the top left 2x2 samples of each pattern, row by row */
+static const gchar *pattern_tiles[] = {"RGGB", "BGGR", "GRBG", "GBRG"};
+
+/* Builds the mosaic a sensor returns for a scene of a single color and
+ * checks that every pixel of the conversion has that color. Both methods
+ * interpolate such a mosaic exactly. */
+static void check_solid(GstPylonDebayer &debayer,
+                        GstPylonDebayerPattern pattern,
+                        GstPylonDebayerMethod method,
+                        GstPylonDebayerOutput output, guint width,
+                        guint height, guint8 r, guint8 g, guint8 b) {
+  std::vector<guint8> src((gsize)width * height);
+  for (guint y = 0; y < height; y++) {
+    for (guint x = 0; x < width; x++) {
+      gchar color = pattern_tiles[pattern][2 * (y % 2) + x % 2];
+      src[y * width + x] = 'R' == color ? r : 'G' == color ? g : b;
+    }
+  }
+
+  debayer.SetFormat(pattern, method, output);
+  guint pixel_stride = debayer.GetPixelStride();
+  std::vector<guint8> dst((gsize)width * height * pixel_stride);
+
+  fail_unless(debayer.Process(src.data(), src.size(), width, dst.data(),
+                              (gsize)width * pixel_stride, width, height));
+
+  /* BT.601 luma, allowing for integer rounding */
+  gint gray = std::lround(0.299 * r + 0.587 * g + 0.114 * b);
+
+  for (gsize i = 0; i < (gsize)width * height; i++) {
+    const guint8 *pixel = &dst[i * pixel_stride];
+    gboolean ok = FALSE;
+
+    switch (output) {
+      case GST_PYLON_DEBAYER_OUTPUT_RGB:
+        ok = pixel[0] == r && pixel[1] == g && pixel[2] == b;
+        break;
+      case GST_PYLON_DEBAYER_OUTPUT_BGRX:
+        ok = pixel[0] == b && pixel[1] == g && pixel[2] == r &&
+             pixel[3] == 0xff;
+        break;
+      case GST_PYLON_DEBAYER_OUTPUT_GRAY8:
+        ok = ABS(pixel[0] - gray) <= 1;
+        break;
+    }
+
+    fail_unless(ok,
+                "Pattern %d, method %d, output %d, %ux%u, color %u/%u/%u: "
+                "pixel %u,%u is wrong",
+                pattern, method, output, width, height, r, g, b,
+                (guint)(i % width), (guint)(i / width));
+  }
+}
+
+static void check_solid_all(GstPylonDebayer &debayer, guint width,
+                            guint height, guint8 r, guint8 g, guint8 b) {
+  for (auto pattern : patterns) {
+    for (auto method : methods) {
+      for (auto output : outputs) {
+        check_solid(debayer, pattern, method, output, width, height, r, g, b);
+      }
+    }
+  }
+}
+
+/* Mirrors coordinates past the border without repeating the edge */
+static guint mirror(gint i, guint size) {
+  if (i < 0) {
+    return -i;
+  }
+  if (i >= (gint)size) {
+    return 2 * (size - 1) - i;
+  }
+
+  return i;
+}
+
+/* The border pixels must be interpolated as if the image was mirrored.
+ * Mirroring the image by two samples on each side keeps the pattern and
+ * covers the largest neighborhood, so its conversion must hold the one of
+ * the image in its center. */
+static void check_borders(GstPylonDebayer &debayer,
+                          GstPylonDebayerPattern pattern,
+                          GstPylonDebayerMethod method,
+                          GstPylonDebayerOutput output, guint width,
+                          guint height) {
+  const guint margin = 2;
+  guint outer_width = width + 2 * margin;
+  guint outer_height = height + 2 * margin;
+  std::vector<guint8> src((gsize)width * height);
+  std::vector<guint8> outer((gsize)outer_width * outer_height);
+
+  /* A multiplicative hash gives a texture without structure */
+  for (gsize i = 0; i < src.size(); i++) {
+    src[i] = (guint32)((i + 1) * 2654435761u) >> 24;
+  }
+
+  for (guint y = 0; y < outer_height; y++) {
+    for (guint x = 0; x < outer_width; x++) {
+      outer[y * outer_width + x] =
+          src[mirror((gint)(y - margin), height) * width +
+              mirror((gint)(x - margin), width)];
+    }
+  }
+
+  debayer.SetFormat(pattern, method, output);
+  gsize row_size = (gsize)width * debayer.GetPixelStride();
+  gsize outer_row_size = (gsize)outer_width * debayer.GetPixelStride();
+  gsize offset = margin * debayer.GetPixelStride();
+  std::vector<guint8> dst(row_size * height);
+  std::vector<guint8> outer_dst(outer_row_size * outer_height);
+
+  fail_unless(debayer.Process(src.data(), src.size(), width, dst.data(),
+                              row_size, width, height));
+  fail_unless(debayer.Process(outer.data(), outer.size(), outer_width,
+                              outer_dst.data(), outer_row_size, outer_width,
+                              outer_height));
+
+  for (guint y = 0; y < height; y++) {
+    fail_unless(0 == memcmp(&dst[y * row_size],
+                            &outer_dst[(y + margin) * outer_row_size + offset],
+                            row_size),
+                "Pattern %d, method %d, output %d, %ux%u: row %u differs",
+                pattern, method, output, width, height, y);
+  }
+}
+
+static void check_borders_all(GstPylonDebayer &debayer, guint width,
+                              guint height) {
+  for (auto pattern : patterns) {
+    for (auto method : methods) {
+      for (auto output : outputs) {
+        check_borders(debayer, pattern, method, output, width, height);
+      }
+    }
+  }
+}
+
+/* The widths cover the vector kernels along with every tail they leave */
+GST_START_TEST(test_debayer_flat) {
+  const guint8 levels[] = {0, 1, 128, 254, 255};
+  GstPylonDebayer debayer;
+
+  for (auto level : levels) {
+    for (guint width = 1; width <= 67; width++) {
+      check_solid_all(debayer, width, 5, level, level, level);
+    }
+    for (guint height = 1; height <= 8; height++) {
+      check_solid_all(debayer, 40, height, level, level, level);
+    }
+  }
+}
+
+GST_END_TEST;
+
+/* Images narrower than the mirrored neighborhood miss colors */
+GST_START_TEST(test_debayer_channels) {
+  const guint8 colors[][3] = {
+      {200, 0, 0}, {0, 200, 0}, {0, 0, 200}, {255, 0, 255}, {30, 140, 250}};
+  GstPylonDebayer debayer;
+
+  for (auto color : colors) {
+    for (guint width = 3; width <= 67; width++) {
+      check_solid_all(debayer, width, 5, color[0], color[1], color[2]);
+    }
+  }
+}
+
+GST_END_TEST;
+
+/* The tall images are split in bands converted in parallel on machines
+ * with several cores, the bands of both images start at different rows */
+GST_START_TEST(test_debayer_borders) {
+  const guint heights[] = {3, 4, 5, 6, 7, 65, 130};
+  GstPylonDebayer debayer;
+
+  for (guint width = 3; width <= 70; width++) {
+    check_borders_all(debayer, width, 5);
+  }
+  for (auto height : heights) {
+    check_borders_all(debayer, 37, height);
+  }
+}
+
+GST_END_TEST;
+
+static Suite *debayer_suite(void) {
+  Suite *s = suite_create("debayer");
+  TCase *tc_chain = tcase_create("general");
+
+  suite_add_tcase(s, tc_chain);
+  tcase_add_test(tc_chain, test_debayer_flat);
+  tcase_add_test(tc_chain, test_debayer_channels);
+  tcase_add_test(tc_chain, test_debayer_borders);
+
+  return s;
+}
+
+GST_CHECK_MAIN(debayer);
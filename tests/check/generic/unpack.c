@@ -0,0 +1,272 @@
+/* Copyright (C) 2022 Basler AG
+ *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *     1. Redistributions of source code must retain the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer.
+ *     2. Redistributions in binary form must reproduce the above
+ *        copyright notice, this list of conditions and the following
+ *        disclaimer in the documentation and/or other materials
+ *        provided with the distribution.
+ *     3. Neither the name of the copyright holder nor the names of
+ *        its contributors may be used to endorse or promote products
+ *        derived from this software without specific prior written
+ *        permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED
+ * OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <gst/check/gstcheck.h>
+
+#include "gstpylonunpack.h"
+
+#include <string.h>
+
+#define MAX_WIDTH 1001
+#define SEED 0x5eed
+
+static gboolean
+is_word_format (GstPylonUnpackFormat format)
+{
+  return GST_PYLON_UNPACK_MONO10 == format
+      || GST_PYLON_UNPACK_MONO12 == format;
+}
+
+/* Unpacks a single pixel, reading one bit at a time so that the result
+ * doesn't depend on the grouping the unpacking relies on */
+static guint16
+reference_pixel (GstPylonUnpackFormat format, guint bits, const guint8 * src,
+    gsize row_offset, guint x)
+{
+  guint16 value = 0;
+  guint i;
+
+  if (is_word_format (format)) {
+    const guint8 *word = src + row_offset + (gsize) x * 2;
+
+    return (word[0] | (word[1] << 8)) & ((1 << bits) - 1);
+  }
+
+  if (GST_PYLON_UNPACK_MONO12_PACKED == format) {
+    const guint8 *group = src + row_offset + x / 2 * 3;
+
+    if (0 == x % 2) {
+      return (group[0] << 4) | (group[1] & 0x0f);
+    } else {
+      return (group[2] << 4) | (group[1] >> 4);
+    }
+  }
+
+  /* PFNC "p" formats are a little endian bit stream */
+  for (i = 0; i < bits; i++) {
+    gsize bit = row_offset * 8 + (gsize) x * bits + i;
+    value |= ((src[bit / 8] >> (bit % 8)) & 1) << i;
+  }
+
+  return value;
+}
+
+static void
+check_unpack (GstPylonUnpackFormat format, guint bits, gboolean msb,
+    guint width, guint height, GRand * rand)
+{
+  guint pixel_bits = is_word_format (format) ? 16 : bits;
+  guint shift = msb ? 16 - bits : 0;
+  gsize row_bits = (gsize) width * pixel_bits;
+  gsize row_bytes = (row_bits + 7) / 8;
+  gboolean byte_aligned = GST_PYLON_UNPACK_MONO12_PACKED == format
+      || 0 == row_bits % 8;
+  /* Lines that start at a byte may be padded, the others are contiguous */
+  gsize src_stride = byte_aligned ? row_bytes + width % 5 : 0;
+  gsize src_size = byte_aligned ? src_stride * (height - 1) + row_bytes :
+      (row_bits * height + 7) / 8;
+  gsize dst_stride = (gsize) width * 2 + 2 * (width % 3);
+  gsize dst_size = dst_stride * height;
+  guint8 *src = g_malloc (src_size);
+  guint8 *dst = g_malloc (dst_size);
+  guint8 *expected = g_malloc (dst_size);
+  gsize i;
+  guint x, y;
+
+  for (i = 0; i < src_size; i++) {
+    src[i] = g_rand_int_range (rand, 0, 256);
+  }
+
+  /* Line padding in the output must be left untouched */
+  memset (dst, 0xa5, dst_size);
+  memset (expected, 0xa5, dst_size);
+
+  for (y = 0; y < height; y++) {
+    gsize row_offset = byte_aligned ? y * src_stride : 0;
+    guint first_pixel = byte_aligned ? 0 : y * width;
+
+    for (x = 0; x < width; x++) {
+      guint16 value =
+          reference_pixel (format, bits, src, row_offset,
+          first_pixel + x) << shift;
+
+      expected[y * dst_stride + 2 * x] = value & 0xff;
+      expected[y * dst_stride + 2 * x + 1] = value >> 8;
+    }
+  }
+
+  fail_unless (gst_pylon_unpack (format, msb, src, src_size, src_stride,
+          dst, dst_stride, width, height));
+
+  if (0 != memcmp (dst, expected, dst_size)) {
+    i = 0;
+    while (dst[i] == expected[i]) {
+      i++;
+    }
+
+    fail ("Format %d, msb %d, %ux%u: byte %" G_GSIZE_FORMAT " of row %"
+        G_GSIZE_FORMAT " is 0x%02x instead of 0x%02x", format, msb, width,
+        height, i % dst_stride, i / dst_stride, dst[i], expected[i]);
+  }
+
+  g_free (expected);
+  g_free (dst);
+  g_free (src);
+}
+
+/* Mono frames are scaled to the full 16 bit range, Bayer frames aren't */
+static void
+check_unpack_all (guint width, guint height, GRand * rand)
+{
+  gboolean msb;
+
+  for (msb = FALSE; msb <= TRUE; msb++) {
+    check_unpack (GST_PYLON_UNPACK_MONO10P, 10, msb, width, height, rand);
+    check_unpack (GST_PYLON_UNPACK_MONO12P, 12, msb, width, height, rand);
+    check_unpack (GST_PYLON_UNPACK_MONO12_PACKED, 12, msb, width, height,
+        rand);
+    check_unpack (GST_PYLON_UNPACK_MONO10, 10, msb, width, height, rand);
+    check_unpack (GST_PYLON_UNPACK_MONO12, 12, msb, width, height, rand);
+  }
+}
+
+GST_START_TEST (test_unpack_get_format)
+{
+  fail_unless_equals_int (gst_pylon_unpack_get_format ("Mono10p"),
+      GST_PYLON_UNPACK_MONO10P);
+  fail_unless_equals_int (gst_pylon_unpack_get_format ("BayerRG12p"),
+      GST_PYLON_UNPACK_MONO12P);
+  fail_unless_equals_int (gst_pylon_unpack_get_format ("BayerGB12Packed"),
+      GST_PYLON_UNPACK_MONO12_PACKED);
+  fail_unless_equals_int (gst_pylon_unpack_get_format ("Mono12"),
+      GST_PYLON_UNPACK_MONO12);
+  fail_unless_equals_int (gst_pylon_unpack_get_format ("Mono8"),
+      GST_PYLON_UNPACK_NONE);
+  fail_unless_equals_int (gst_pylon_unpack_get_format ("BayerRG12"),
+      GST_PYLON_UNPACK_NONE);
+}
+
+GST_END_TEST;
+
+/* Covers the vector kernels along with every possible scalar tail */
+GST_START_TEST (test_unpack_widths)
+{
+  GRand *rand = g_rand_new_with_seed (SEED);
+  guint width;
+
+  for (width = 1; width <= MAX_WIDTH; width++) {
+    check_unpack_all (width, 1, rand);
+    check_unpack_all (width, 3, rand);
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_unpack_heights)
+{
+  const guint widths[] = { 1, 15, 16, 17, 33, 250, 640 };
+  GRand *rand = g_rand_new_with_seed (SEED);
+  guint i, height;
+
+  for (i = 0; i < G_N_ELEMENTS (widths); i++) {
+    for (height = 1; height <= 33; height += 2) {
+      check_unpack_all (widths[i], height, rand);
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_unpack_empty)
+{
+  guint8 src = 0;
+  guint8 dst = 0;
+
+  fail_unless (gst_pylon_unpack (GST_PYLON_UNPACK_MONO10P, FALSE, &src, 0, 0,
+          &dst, 0, 0, 10));
+  fail_unless (gst_pylon_unpack (GST_PYLON_UNPACK_MONO10P, FALSE, &src, 0, 0,
+          &dst, 0, 10, 0));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_unpack_short_buffer)
+{
+  guint8 src[64] = { 0 };
+  guint8 dst[256];
+
+  /* 3 lines of 13 Mono10p pixels take 49 bytes */
+  fail_unless (gst_pylon_unpack (GST_PYLON_UNPACK_MONO10P, FALSE, src, 49, 0,
+          dst, 26, 13, 3));
+  fail_if (gst_pylon_unpack (GST_PYLON_UNPACK_MONO10P, FALSE, src, 48, 0,
+          dst, 26, 13, 3));
+
+  /* The last line doesn't need its padding */
+  fail_unless (gst_pylon_unpack (GST_PYLON_UNPACK_MONO12_PACKED, FALSE, src,
+          52, 20, dst, 16, 8, 3));
+  fail_if (gst_pylon_unpack (GST_PYLON_UNPACK_MONO12_PACKED, FALSE, src, 51,
+          20, dst, 16, 8, 3));
+
+  /* 3 lines of 5 Mono12 pixels take 30 bytes */
+  fail_unless (gst_pylon_unpack (GST_PYLON_UNPACK_MONO12, TRUE, src, 30, 0,
+          dst, 10, 5, 3));
+  fail_if (gst_pylon_unpack (GST_PYLON_UNPACK_MONO12, TRUE, src, 29, 0,
+          dst, 10, 5, 3));
+}
+
+GST_END_TEST;
+
+static Suite *
+unpack_suite (void)
+{
+  Suite *s = suite_create ("unpack");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_unpack_get_format);
+  tcase_add_test (tc_chain, test_unpack_widths);
+  tcase_add_test (tc_chain, test_unpack_heights);
+  tcase_add_test (tc_chain, test_unpack_empty);
+  tcase_add_test (tc_chain, test_unpack_short_buffer);
+
+  return s;
+}
+
+GST_CHECK_MAIN (unpack);
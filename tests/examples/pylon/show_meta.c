@@ -177,8 +177,6 @@ cb_have_data (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
   Context *ctx = (Context *) user_data;
   gchar *meta_str = NULL;
   gchar *tmp_str = NULL;
-  gint64 int_chunk;
-  gdouble float_chunk;
 
   g_return_val_if_fail (ctx, GST_PAD_PROBE_DROP);
 
@@ -192,22 +190,22 @@ cb_have_data (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
       meta->offset.offset_x, meta->offset.offset_y, meta->timestamp);
 
   /* show chunks embedded in the stream */
-  for (int idx = 0; idx < gst_structure_n_fields (meta->chunks); idx++) {
-    const gchar *chunk_name = gst_structure_nth_field_name (meta->chunks, idx);
-    GType chunk_type = gst_structure_get_field_type (meta->chunks, chunk_name);
+  for (guint idx = 0; idx < gst_pylon_meta_get_n_chunks (meta); idx++) {
+    const GstPylonChunk *chunk = gst_pylon_meta_get_chunk (meta, idx);
+    const gchar *chunk_name = g_quark_to_string (chunk->name);
     /* display double and int types */
-    switch (chunk_type) {
-      case G_TYPE_INT64:
-        gst_structure_get_int64 (meta->chunks, chunk_name, &int_chunk);
+    switch (chunk->type) {
+      case GST_PYLON_CHUNK_TYPE_INT64:
         tmp_str =
-            g_strdup_printf ("%s%s_%ld ", meta_str, chunk_name, int_chunk);
+            g_strdup_printf ("%s%s_%ld ", meta_str, chunk_name,
+            chunk->value.v_int64);
         g_free (meta_str);
         meta_str = tmp_str;
         break;
-      case G_TYPE_DOUBLE:
-        gst_structure_get_double (meta->chunks, chunk_name, &float_chunk);
+      case GST_PYLON_CHUNK_TYPE_DOUBLE:
         tmp_str =
-            g_strdup_printf ("%s%s_%.2f ", meta_str, chunk_name, float_chunk);
+            g_strdup_printf ("%s%s_%.2f ", meta_str, chunk_name,
+            chunk->value.v_double);
         g_free (meta_str);
         meta_str = tmp_str;
         break;